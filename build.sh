@@ -29,6 +29,14 @@ build_uefitools() {
 	make -C edk2/BaseTools -j$(getconf _NPROCESSORS_ONLN) && touch .uefitools_done
 }
 
+build_logos() {
+	echo " => Converting boot logos"
+	for vendor in Pine64 OrangePi; do
+		./scripts/bmp2raw.py edk2-rockchip/Platform/${vendor}/Drivers/LogoDxe/Logo.bmp \
+		    Build/Logo/${vendor}/Logo
+	done
+}
+
 build_uefi() {
 	vendor=$1
 	board=$2
@@ -83,6 +91,7 @@ test -r ${RKBIN}/${BL31} || (echo "${RKBIN}/${BL31} not found"; false)
 . edk2/edksetup.sh
 
 build_uefitools
+build_logos
 
 for board in ${RKUEFIBOARDS}; do
 	case ${board} in
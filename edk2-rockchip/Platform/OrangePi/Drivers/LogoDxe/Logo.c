@@ -12,31 +12,32 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 **/
 #include <Uefi.h>
-#include <Protocol/HiiDatabase.h>
 #include <Protocol/GraphicsOutput.h>
-#include <Protocol/HiiImageEx.h>
+#include <Protocol/HiiImage.h>
 #include <Protocol/PlatformLogo.h>
-#include <Protocol/HiiPackageList.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Library/DxeServicesLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/DebugLib.h>
 
+//
+// Logo.bmp is converted at build time by scripts/bmp2raw.py and stored in
+// the gRk356xLogoFileGuid freeform file as two raw sections: the dimensions,
+// then the pixels already in GOP Blt format. BootLogoLib gets the pixels as
+// they are, so showing the logo costs one section read and one Blt instead
+// of an HII image decode. The logo is centered rather than scaled, so the
+// same pixels serve every display mode. The firmware volume is LZMA
+// compressed, which keeps the raw pixels small in the FD.
+//
+#define LOGO_DIM_SECTION        0
+#define LOGO_PIXEL_SECTION      1
+
 typedef struct {
-  EFI_IMAGE_ID                          ImageId;
-  EDKII_PLATFORM_LOGO_DISPLAY_ATTRIBUTE Attribute;
-  INTN                                  OffsetX;
-  INTN                                  OffsetY;
-} LOGO_ENTRY;
-
-EFI_HII_IMAGE_EX_PROTOCOL *mHiiImageEx;
-EFI_HII_HANDLE            mHiiHandle;
-LOGO_ENTRY                mLogos[] = {
-  {
-    IMAGE_TOKEN (IMG_LOGO),
-    EdkiiPlatformLogoDisplayAttributeCenter,
-    0,
-    0
-  }
-};
+  UINT32  Width;
+  UINT32  Height;
+} LOGO_DIMENSIONS;
+
+STATIC LOGO_DIMENSIONS mLogoDim;
 
 /**
   Load a platform logo image and return its data and attributes.
@@ -62,22 +63,44 @@ GetImage (
      OUT INTN                                  *OffsetY
   )
 {
-  UINT32 Current;
+  EFI_STATUS  Status;
+  VOID        *Pixels;
+  UINTN       Size;
+
   if (Instance == NULL || Image == NULL ||
       Attribute == NULL || OffsetX == NULL || OffsetY == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  Current = *Instance;
-  if (Current >= ARRAY_SIZE (mLogos)) {
+  if (*Instance != 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // The caller owns the returned bitmap and frees it, so hand over the
+  // section buffer itself.
+  //
+  Status = GetSectionFromAnyFv (&gRk356xLogoFileGuid, EFI_SECTION_RAW,
+             LOGO_PIXEL_SECTION, &Pixels, &Size);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  if (Size != mLogoDim.Width * mLogoDim.Height * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)) {
+    DEBUG ((DEBUG_ERROR, "Logo: %u bytes of pixels for a %ux%u logo\n",
+            (UINT32)Size, mLogoDim.Width, mLogoDim.Height));
+    FreePool (Pixels);
     return EFI_NOT_FOUND;
   }
 
   (*Instance)++;
-  *Attribute = mLogos[Current].Attribute;
-  *OffsetX = mLogos[Current].OffsetX;
-  *OffsetY = mLogos[Current].OffsetY;
-  return mHiiImageEx->GetImageEx (mHiiImageEx, mHiiHandle, mLogos[Current].ImageId, Image);
+  Image->Flags = 0;
+  Image->Width = (UINT16)mLogoDim.Width;
+  Image->Height = (UINT16)mLogoDim.Height;
+  Image->Bitmap = Pixels;
+  *Attribute = EdkiiPlatformLogoDisplayAttributeCenter;
+  *OffsetX = 0;
+  *OffsetY = 0;
+  return EFI_SUCCESS;
 }
 
 EDKII_PLATFORM_LOGO_PROTOCOL mPlatformLogo = {
@@ -104,56 +127,35 @@ InitializeLogo (
   )
 {
   EFI_STATUS                  Status;
-  EFI_HII_PACKAGE_LIST_HEADER *PackageList;
-  EFI_HII_DATABASE_PROTOCOL   *HiiDatabase;
+  LOGO_DIMENSIONS             *Dim;
+  UINTN                       Size;
   EFI_HANDLE                  Handle;
 
-  Status = gBS->LocateProtocol (
-                  &gEfiHiiDatabaseProtocolGuid,
-                  NULL,
-                  (VOID**) &HiiDatabase
-                );
-  ASSERT_EFI_ERROR (Status);
-
-  Status = gBS->LocateProtocol (
-                  &gEfiHiiImageExProtocolGuid,
-                  NULL,
-                  (VOID**) &mHiiImageEx
-                );
-  ASSERT_EFI_ERROR (Status);
-
-  //
-  // Retrieve HII package list from ImageHandle
-  //
-  Status = gBS->OpenProtocol (
-                  ImageHandle,
-                  &gEfiHiiPackageListProtocolGuid,
-                  (VOID**)&PackageList,
-                  ImageHandle,
-                  NULL,
-                  EFI_OPEN_PROTOCOL_GET_PROTOCOL
-                );
+  Status = GetSectionFromAnyFv (&gRk356xLogoFileGuid, EFI_SECTION_RAW,
+             LOGO_DIM_SECTION, (VOID **)&Dim, &Size);
   if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "HII Image Package with logo not found in PE/COFF resource section\n"));
+    DEBUG ((DEBUG_ERROR, "Logo not found in firmware volume\n"));
     return Status;
   }
+  if (Size < sizeof (*Dim)) {
+    FreePool (Dim);
+    return EFI_NOT_FOUND;
+  }
+  mLogoDim = *Dim;
+  FreePool (Dim);
 
-  //
-  // Publish HII package list to HII Database.
-  //
-  Status = HiiDatabase->NewPackageList (
-                          HiiDatabase,
-                          PackageList,
-                          NULL,
-                          &mHiiHandle
-                        );
-  if (!EFI_ERROR (Status)) {
-    Handle = NULL;
-    Status = gBS->InstallMultipleProtocolInterfaces (
-                    &Handle,
-                    &gEdkiiPlatformLogoProtocolGuid, &mPlatformLogo,
-                    NULL
-                  );
+  if (mLogoDim.Width == 0 || mLogoDim.Width > MAX_UINT16 ||
+      mLogoDim.Height == 0 || mLogoDim.Height > MAX_UINT16) {
+    DEBUG ((DEBUG_ERROR, "Logo has bad dimensions %ux%u\n",
+            mLogoDim.Width, mLogoDim.Height));
+    return EFI_NOT_FOUND;
   }
+
+  Handle = NULL;
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &Handle,
+                  &gEdkiiPlatformLogoProtocolGuid, &mPlatformLogo,
+                  NULL
+                );
   return Status;
 }
@@ -0,0 +1,417 @@
+/** @file
+ *
+ *  Storage and memory throughput benchmark.
+ *
+ *  bench                 List block devices.
+ *  bench -b <index>      Sequential and random read tests on a block device.
+ *  bench -m              memcpy/memset bandwidth to WB, WC and UC memory and
+ *                        to the framebuffer.
+ *
+ *  Test sizes and the random read pattern are fixed so that numbers from
+ *  different firmware releases can be compared directly.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/ShellLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+
+#include <Protocol/BlockIo.h>
+#include <Protocol/Cpu.h>
+#include <Protocol/GraphicsOutput.h>
+
+#include "BenchMath.h"
+
+/* Data read by each sequential pass, capped at the device size */
+#define BENCH_SEQ_TOTAL           SIZE_64MB
+/* Random reads issued, and the span they are spread over */
+#define BENCH_RANDOM_COUNT        2000
+#define BENCH_RANDOM_SIZE         SIZE_4KB
+#define BENCH_RANDOM_SPAN         SIZE_4GB
+/* Buffer used for the memory tests; larger than any RK356x cache */
+#define BENCH_MEM_SIZE            SIZE_8MB
+
+STATIC CONST UINTN mSeqSizes[] = { SIZE_4KB, SIZE_64KB, SIZE_1MB };
+
+STATIC CONST SHELL_PARAM_ITEM mParamList[] = {
+  { L"-b", TypeValue },
+  { L"-m", TypeFlag },
+  { NULL, TypeMax }
+};
+
+STATIC BENCH_COUNTER mCounter;
+
+STATIC
+VOID
+BenchInitCounter (
+  VOID
+  )
+{
+  mCounter.Frequency = GetPerformanceCounterProperties (&mCounter.StartValue,
+                         &mCounter.EndValue);
+}
+
+STATIC
+UINT64
+BenchNsSince (
+  IN UINT64  Start
+  )
+{
+  return BenchTicksToNs (&mCounter,
+           BenchElapsedTicks (&mCounter, Start, GetPerformanceCounter ()));
+}
+
+STATIC
+VOID
+BenchPrintRate (
+  IN CONST CHAR16  *Label,
+  IN UINT64        Bytes,
+  IN UINT64        Ns
+  )
+{
+  UINT64 Whole;
+  UINT32 Hundredths;
+
+  BenchSplitMiB (BenchRateKiB (Bytes, Ns), &Whole, &Hundredths);
+  Print (L"  %-28s %6lu.%02u MiB/s\n", Label, Whole, Hundredths);
+}
+
+/**
+  Return the physical block devices, in handle database order.
+
+**/
+STATIC
+EFI_STATUS
+BenchGetBlockDevices (
+  OUT EFI_HANDLE  **Handles,
+  OUT UINTN       *Count
+  )
+{
+  EFI_STATUS Status;
+  EFI_HANDLE *Buffer;
+  EFI_BLOCK_IO_PROTOCOL *BlockIo;
+  UINTN NumHandles;
+  UINTN Index;
+
+  Status = gBS->LocateHandleBuffer (ByProtocol, &gEfiBlockIoProtocolGuid,
+                  NULL, &NumHandles, &Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  *Count = 0;
+  for (Index = 0; Index < NumHandles; Index++) {
+    Status = gBS->HandleProtocol (Buffer[Index], &gEfiBlockIoProtocolGuid,
+                    (VOID **)&BlockIo);
+    if (EFI_ERROR (Status) || BlockIo->Media->LogicalPartition ||
+        !BlockIo->Media->MediaPresent) {
+      continue;
+    }
+    Buffer[(*Count)++] = Buffer[Index];
+  }
+
+  *Handles = Buffer;
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+BenchListDevices (
+  IN EFI_HANDLE  *Handles,
+  IN UINTN       First,
+  IN UINTN       Last
+  )
+{
+  EFI_BLOCK_IO_PROTOCOL *BlockIo;
+  CHAR16 *Text;
+  UINTN Index;
+
+  for (Index = First; Index <= Last; Index++) {
+    gBS->HandleProtocol (Handles[Index], &gEfiBlockIoProtocolGuid, (VOID **)&BlockIo);
+    Text = ConvertDevicePathToText (DevicePathFromHandle (Handles[Index]), FALSE, TRUE);
+    Print (L"%2lu: %8lu MiB, %4u byte blocks  %s\n", Index,
+      RShiftU64 (MultU64x32 (BlockIo->Media->LastBlock + 1, BlockIo->Media->BlockSize), 20),
+      BlockIo->Media->BlockSize, Text != NULL ? Text : L"?");
+    if (Text != NULL) {
+      FreePool (Text);
+    }
+  }
+}
+
+STATIC
+EFI_STATUS
+BenchBlockDevice (
+  IN EFI_HANDLE  Handle
+  )
+{
+  EFI_STATUS Status;
+  EFI_BLOCK_IO_PROTOCOL *BlockIo;
+  EFI_BLOCK_IO_MEDIA *Media;
+  UINT64 DeviceSize;
+  UINT64 Total;
+  UINT64 Done;
+  UINT64 Start;
+  UINT64 Ns;
+  UINT64 Span;
+  UINT64 Seed;
+  UINT64 Slots;
+  UINTN ReqSize;
+  UINTN Index;
+  VOID *Buffer;
+  CHAR16 Label[32];
+
+  Status = gBS->HandleProtocol (Handle, &gEfiBlockIoProtocolGuid, (VOID **)&BlockIo);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  Media = BlockIo->Media;
+  DeviceSize = MultU64x32 (Media->LastBlock + 1, Media->BlockSize);
+
+  Buffer = AllocateAlignedPages (EFI_SIZE_TO_PAGES (mSeqSizes[ARRAY_SIZE (mSeqSizes) - 1]),
+             MAX (Media->IoAlign, EFI_PAGE_SIZE));
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Total = MIN (DeviceSize, BENCH_SEQ_TOTAL);
+  for (Index = 0; Index < ARRAY_SIZE (mSeqSizes); Index++) {
+    ReqSize = ALIGN_VALUE (mSeqSizes[Index], Media->BlockSize);
+    Done = 0;
+    Start = GetPerformanceCounter ();
+    while (Done + ReqSize <= Total) {
+      Status = BlockIo->ReadBlocks (BlockIo, Media->MediaId,
+                          DivU64x32 (Done, Media->BlockSize), ReqSize, Buffer);
+      if (EFI_ERROR (Status)) {
+        Print (L"Read failed at offset 0x%lx: %r\n", Done, Status);
+        goto Exit;
+      }
+      Done += ReqSize;
+    }
+    Ns = BenchNsSince (Start);
+    UnicodeSPrint (Label, sizeof (Label), L"seq read %4lu KiB", (UINT64)(ReqSize >> 10));
+    BenchPrintRate (Label, Done, Ns);
+  }
+
+  ReqSize = ALIGN_VALUE (BENCH_RANDOM_SIZE, Media->BlockSize);
+  Span = MIN (DeviceSize, BENCH_RANDOM_SPAN);
+  Slots = DivU64x32 (Span, (UINT32)ReqSize);
+  if (Slots == 0) {
+    Print (L"Device too small for random reads, skipped\n");
+    goto Exit;
+  }
+  Seed = BENCH_RANDOM_SEED;
+  Start = GetPerformanceCounter ();
+  for (Index = 0; Index < BENCH_RANDOM_COUNT; Index++) {
+    Done = MultU64x32 (ModU64x32 (BenchRandom (&Seed), (UINT32)MIN (Slots, MAX_UINT32)),
+             (UINT32)ReqSize);
+    Status = BlockIo->ReadBlocks (BlockIo, Media->MediaId,
+                        DivU64x32 (Done, Media->BlockSize), ReqSize, Buffer);
+    if (EFI_ERROR (Status)) {
+      Print (L"Read failed at offset 0x%lx: %r\n", Done, Status);
+      goto Exit;
+    }
+  }
+  Ns = BenchNsSince (Start);
+  UnicodeSPrint (Label, sizeof (Label), L"random read %lu KiB", (UINT64)(ReqSize >> 10));
+  BenchPrintRate (Label, MultU64x32 (BENCH_RANDOM_COUNT, (UINT32)ReqSize), Ns);
+  Print (L"  %-28s %9lu IOPS\n", Label, BenchOpsPerSecond (BENCH_RANDOM_COUNT, Ns));
+
+Exit:
+  FreeAlignedPages (Buffer, EFI_SIZE_TO_PAGES (mSeqSizes[ARRAY_SIZE (mSeqSizes) - 1]));
+  return Status;
+}
+
+/**
+  Run copy, fill and read tests against a destination buffer.
+
+  @param[in]  Name              Short description of the destination.
+  @param[in]  Dest              Destination buffer.
+  @param[in]  Source            Write-back cached source buffer.
+  @param[in]  Size              Size of both buffers.
+  @param[in]  Passes            Number of times each test is repeated.
+
+**/
+STATIC
+VOID
+BenchMemory (
+  IN CONST CHAR16  *Name,
+  IN VOID          *Dest,
+  IN VOID          *Source,
+  IN UINTN         Size,
+  IN UINTN         Passes
+  )
+{
+  UINT64 Start;
+  UINTN Pass;
+  CHAR16 Label[32];
+
+  Start = GetPerformanceCounter ();
+  for (Pass = 0; Pass < Passes; Pass++) {
+    CopyMem (Dest, Source, Size);
+  }
+  UnicodeSPrint (Label, sizeof (Label), L"memcpy WB -> %s", Name);
+  BenchPrintRate (Label, MultU64x32 (Size, (UINT32)Passes), BenchNsSince (Start));
+
+  Start = GetPerformanceCounter ();
+  for (Pass = 0; Pass < Passes; Pass++) {
+    SetMem32 (Dest, Size, 0);
+  }
+  UnicodeSPrint (Label, sizeof (Label), L"memset %s", Name);
+  BenchPrintRate (Label, MultU64x32 (Size, (UINT32)Passes), BenchNsSince (Start));
+
+  Start = GetPerformanceCounter ();
+  for (Pass = 0; Pass < Passes; Pass++) {
+    CopyMem (Source, Dest, Size);
+  }
+  UnicodeSPrint (Label, sizeof (Label), L"memcpy %s -> WB", Name);
+  BenchPrintRate (Label, MultU64x32 (Size, (UINT32)Passes), BenchNsSince (Start));
+}
+
+STATIC
+EFI_STATUS
+BenchMemoryTypes (
+  VOID
+  )
+{
+  EFI_STATUS Status;
+  EFI_CPU_ARCH_PROTOCOL *Cpu;
+  EFI_GRAPHICS_OUTPUT_PROTOCOL *Gop;
+  EFI_PHYSICAL_ADDRESS DestBase;
+  VOID *Source;
+  VOID *Dest;
+  VOID *Saved;
+  UINTN FbSize;
+
+  Status = gBS->LocateProtocol (&gEfiCpuArchProtocolGuid, NULL, (VOID **)&Cpu);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Source = AllocatePages (EFI_SIZE_TO_PAGES (BENCH_MEM_SIZE));
+  Dest = AllocatePages (EFI_SIZE_TO_PAGES (BENCH_MEM_SIZE));
+  if (Source == NULL || Dest == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+  SetMem (Source, BENCH_MEM_SIZE, 0x5A);
+  DestBase = (EFI_PHYSICAL_ADDRESS)(UINTN)Dest;
+
+  BenchMemory (L"WB", Dest, Source, BENCH_MEM_SIZE, 32);
+
+  Status = Cpu->SetMemoryAttributes (Cpu, DestBase, BENCH_MEM_SIZE, EFI_MEMORY_WC);
+  if (!EFI_ERROR (Status)) {
+    BenchMemory (L"WC", Dest, Source, BENCH_MEM_SIZE, 8);
+  }
+  Status = Cpu->SetMemoryAttributes (Cpu, DestBase, BENCH_MEM_SIZE, EFI_MEMORY_UC);
+  if (!EFI_ERROR (Status)) {
+    BenchMemory (L"UC", Dest, Source, BENCH_MEM_SIZE, 2);
+  }
+  Status = Cpu->SetMemoryAttributes (Cpu, DestBase, BENCH_MEM_SIZE, EFI_MEMORY_WB);
+  if (EFI_ERROR (Status)) {
+    // Leak the pages rather than hand them back with the wrong attributes.
+    Print (L"Could not restore WB attributes: %r\n", Status);
+    Dest = NULL;
+    goto Exit;
+  }
+
+  Status = gBS->LocateProtocol (&gEfiGraphicsOutputProtocolGuid, NULL, (VOID **)&Gop);
+  if (!EFI_ERROR (Status) && Gop->Mode->FrameBufferBase != 0) {
+    // Preserve the screen contents across the test.
+    FbSize = MIN (Gop->Mode->FrameBufferSize, BENCH_MEM_SIZE);
+    Saved = AllocateCopyPool (FbSize,
+              (VOID *)(UINTN)Gop->Mode->FrameBufferBase);
+    if (Saved != NULL) {
+      BenchMemory (L"FB", (VOID *)(UINTN)Gop->Mode->FrameBufferBase,
+        Source, FbSize, 8);
+      CopyMem ((VOID *)(UINTN)Gop->Mode->FrameBufferBase, Saved, FbSize);
+      FreePool (Saved);
+    }
+  }
+  Status = EFI_SUCCESS;
+
+Exit:
+  if (Source != NULL) {
+    FreePages (Source, EFI_SIZE_TO_PAGES (BENCH_MEM_SIZE));
+  }
+  if (Dest != NULL) {
+    FreePages (Dest, EFI_SIZE_TO_PAGES (BENCH_MEM_SIZE));
+  }
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BenchMain (
+  IN EFI_HANDLE         ImageHandle,
+  IN EFI_SYSTEM_TABLE   *SystemTable
+  )
+{
+  EFI_STATUS Status;
+  LIST_ENTRY *Package;
+  CHAR16 *ProblemParam;
+  CONST CHAR16 *Value;
+  EFI_HANDLE *Handles;
+  UINTN Count;
+  UINTN Index;
+
+  Status = ShellCommandLineParse (mParamList, &Package, &ProblemParam, TRUE);
+  if (EFI_ERROR (Status)) {
+    if (Status == EFI_VOLUME_CORRUPTED && ProblemParam != NULL) {
+      Print (L"bench: unknown option %s\n", ProblemParam);
+      FreePool (ProblemParam);
+    }
+    return Status;
+  }
+
+  BenchInitCounter ();
+  Handles = NULL;
+
+  if (ShellCommandLineGetFlag (Package, L"-m")) {
+    Print (L"Memory bandwidth (%u KiB buffers):\n", BENCH_MEM_SIZE >> 10);
+    Status = BenchMemoryTypes ();
+    goto Exit;
+  }
+
+  Status = BenchGetBlockDevices (&Handles, &Count);
+  if (EFI_ERROR (Status)) {
+    Print (L"bench: no block devices\n");
+    goto Exit;
+  }
+
+  Value = ShellCommandLineGetValue (Package, L"-b");
+  if (Value == NULL) {
+    if (Count > 0) {
+      BenchListDevices (Handles, 0, Count - 1);
+    }
+    goto Exit;
+  }
+
+  Index = ShellStrToUintn (Value);
+  if (Index >= Count) {
+    Print (L"bench: no block device %s\n", Value);
+    Status = EFI_INVALID_PARAMETER;
+    goto Exit;
+  }
+
+  BenchListDevices (Handles, Index, Index);
+  Status = BenchBlockDevice (Handles[Index]);
+
+Exit:
+  if (Handles != NULL) {
+    FreePool (Handles);
+  }
+  ShellCommandLineFreeVarList (Package);
+  return Status;
+}
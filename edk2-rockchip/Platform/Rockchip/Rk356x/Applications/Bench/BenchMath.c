@@ -0,0 +1,125 @@
+/** @file
+ *
+ *  Timing and rate arithmetic for the Bench application.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#include <Library/BaseLib.h>
+
+#include "BenchMath.h"
+
+UINT64
+BenchElapsedTicks (
+  IN CONST BENCH_COUNTER  *Counter,
+  IN UINT64               Start,
+  IN UINT64               End
+  )
+{
+  UINT64 Low;
+  UINT64 High;
+
+  if (Counter->StartValue > Counter->EndValue) {
+    // Down counter: swap so the maths below only deals with counting up.
+    Low = Counter->EndValue;
+    High = Counter->StartValue;
+    if (Start >= End) {
+      return Start - End;
+    }
+    return (Start - Low) + (High - End) + 1;
+  }
+
+  Low = Counter->StartValue;
+  High = Counter->EndValue;
+  if (End >= Start) {
+    return End - Start;
+  }
+  return (High - Start) + (End - Low) + 1;
+}
+
+UINT64
+BenchTicksToNs (
+  IN CONST BENCH_COUNTER  *Counter,
+  IN UINT64               Ticks
+  )
+{
+  UINT64 Seconds;
+  UINT64 Remainder;
+
+  if (Counter->Frequency == 0) {
+    return 0;
+  }
+
+  Seconds = DivU64x64Remainder (Ticks, Counter->Frequency, &Remainder);
+  return MultU64x32 (Seconds, 1000000000) +
+         DivU64x64Remainder (MultU64x32 (Remainder, 1000000000), Counter->Frequency, NULL);
+}
+
+UINT64
+BenchRateKiB (
+  IN UINT64  Bytes,
+  IN UINT64  Ns
+  )
+{
+  UINT64 KiB;
+  UINT64 Seconds;
+  UINT64 Remainder;
+
+  if (Ns == 0) {
+    return 0;
+  }
+
+  KiB = RShiftU64 (Bytes, 10);
+
+  // KiB * 10^9 / Ns, split so the remainder product cannot overflow. Past
+  // one second, microsecond resolution is plenty and keeps that true.
+  if (Ns < 1000000000) {
+    Seconds = DivU64x64Remainder (KiB, Ns, &Remainder);
+    return MultU64x32 (Seconds, 1000000000) +
+           DivU64x64Remainder (MultU64x32 (Remainder, 1000000000), Ns, NULL);
+  }
+
+  Ns = DivU64x32 (Ns, 1000);
+  Seconds = DivU64x64Remainder (KiB, Ns, &Remainder);
+  return MultU64x32 (Seconds, 1000000) +
+         DivU64x64Remainder (MultU64x32 (Remainder, 1000000), Ns, NULL);
+}
+
+UINT64
+BenchOpsPerSecond (
+  IN UINT64  Ops,
+  IN UINT64  Ns
+  )
+{
+  return BenchRateKiB (LShiftU64 (Ops, 10), Ns);
+}
+
+VOID
+BenchSplitMiB (
+  IN  UINT64  RateKiB,
+  OUT UINT64  *Whole,
+  OUT UINT32  *Hundredths
+  )
+{
+  *Whole = RShiftU64 (RateKiB, 10);
+  *Hundredths = (UINT32)(((RateKiB & 0x3FF) * 100) >> 10);
+}
+
+UINT64
+BenchRandom (
+  IN OUT UINT64  *State
+  )
+{
+  UINT64 X;
+
+  X = *State;
+  X ^= LShiftU64 (X, 13);
+  X ^= RShiftU64 (X, 7);
+  X ^= LShiftU64 (X, 17);
+  *State = X;
+
+  return X;
+}
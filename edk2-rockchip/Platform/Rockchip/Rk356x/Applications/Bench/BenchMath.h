@@ -0,0 +1,91 @@
+/** @file
+ *
+ *  Timing and rate arithmetic for the Bench application.
+ *
+ *  Everything in here only depends on BaseLib so it can be built and
+ *  checked outside of firmware.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#ifndef BENCH_MATH_H__
+#define BENCH_MATH_H__
+
+#include <Base.h>
+
+/* Seed for the random read pattern; fixed so runs are comparable */
+#define BENCH_RANDOM_SEED         0x9E3779B97F4A7C15ULL
+
+typedef struct {
+  UINT64    Frequency;
+  UINT64    StartValue;
+  UINT64    EndValue;
+} BENCH_COUNTER;
+
+/**
+  Return the number of ticks between two counter samples, allowing for a
+  counter that counts down and for a single wrap.
+
+**/
+UINT64
+BenchElapsedTicks (
+  IN CONST BENCH_COUNTER  *Counter,
+  IN UINT64               Start,
+  IN UINT64               End
+  );
+
+/**
+  Convert counter ticks to nanoseconds without overflowing for runs of
+  several minutes at GHz counter rates.
+
+**/
+UINT64
+BenchTicksToNs (
+  IN CONST BENCH_COUNTER  *Counter,
+  IN UINT64               Ticks
+  );
+
+/**
+  Return a transfer rate in KiB/s, or 0 if no time was measured.
+
+**/
+UINT64
+BenchRateKiB (
+  IN UINT64  Bytes,
+  IN UINT64  Ns
+  );
+
+/**
+  Return operations per second, or 0 if no time was measured.
+
+**/
+UINT64
+BenchOpsPerSecond (
+  IN UINT64  Ops,
+  IN UINT64  Ns
+  );
+
+/**
+  Split a KiB/s rate into whole MiB/s and hundredths for printing.
+
+**/
+VOID
+BenchSplitMiB (
+  IN  UINT64  RateKiB,
+  OUT UINT64  *Whole,
+  OUT UINT32  *Hundredths
+  );
+
+/**
+  Advance the xorshift64 state and return the next pseudo-random value.
+
+**/
+UINT64
+BenchRandom (
+  IN OUT UINT64  *State
+  );
+
+#endif /* BENCH_MATH_H__ */
@@ -0,0 +1,158 @@
+/** @file
+ *
+ *  Host test for the Bench timing and rate arithmetic.
+ *
+ *  Built as a Linux program together with BenchMath.c. Each helper is
+ *  checked against values worked out by hand, including counters that
+ *  count down or wrap and runs long enough to overflow a naive
+ *  ticks * 10^9 product.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <Base.h>
+
+#include "BenchMath.h"
+
+STATIC UINTN mFailures;
+STATIC UINTN mChecks;
+
+STATIC
+VOID
+Check (
+  IN CONST char *Name,
+  IN UINT64     Got,
+  IN UINT64     Want
+  )
+{
+  mChecks++;
+  if (Got == Want) {
+    return;
+  }
+
+  printf ("FAIL %s: got %llu (0x%llx), expected %llu (0x%llx)\n", Name,
+          (unsigned long long)Got, (unsigned long long)Got,
+          (unsigned long long)Want, (unsigned long long)Want);
+  mFailures++;
+}
+
+STATIC
+VOID
+TestElapsedTicks (
+  VOID
+  )
+{
+  CONST BENCH_COUNTER Up32 = { 24000000, 0, 0xFFFFFFFF };
+  CONST BENCH_COUNTER Down32 = { 24000000, 0xFFFFFFFF, 0 };
+  CONST BENCH_COUNTER Up64 = { 24000000, 0, ~0ULL };
+  CONST BENCH_COUNTER Offset = { 1000, 100, 199 };
+
+  Check ("ElapsedTicks up", BenchElapsedTicks (&Up32, 10, 110), 100);
+  Check ("ElapsedTicks up, none", BenchElapsedTicks (&Up32, 42, 42), 0);
+  Check ("ElapsedTicks up, wrap", BenchElapsedTicks (&Up32, 0xFFFFFFF0, 0x10), 0x20);
+  Check ("ElapsedTicks down", BenchElapsedTicks (&Down32, 110, 10), 100);
+  Check ("ElapsedTicks down, wrap", BenchElapsedTicks (&Down32, 0x10, 0xFFFFFFF0), 0x20);
+  Check ("ElapsedTicks 64-bit, wrap", BenchElapsedTicks (&Up64, ~0ULL - 4, 5), 10);
+  /* A counter running from 100 to 199 has 100 distinct values */
+  Check ("ElapsedTicks offset, wrap", BenchElapsedTicks (&Offset, 190, 110), 20);
+}
+
+STATIC
+VOID
+TestTicksToNs (
+  VOID
+  )
+{
+  CONST BENCH_COUNTER Arch = { 24000000, 0, ~0ULL };
+  CONST BENCH_COUNTER Fast = { 3000000000ULL, 0, ~0ULL };
+  CONST BENCH_COUNTER Broken = { 0, 0, ~0ULL };
+
+  Check ("TicksToNs one second", BenchTicksToNs (&Arch, 24000000), 1000000000);
+  Check ("TicksToNs one tick", BenchTicksToNs (&Arch, 1), 41);
+  Check ("TicksToNs 1.5 s", BenchTicksToNs (&Arch, 36000000), 1500000000);
+  /* Ten minutes at 3 GHz: ticks * 10^9 alone would overflow 64 bits */
+  Check ("TicksToNs 10 min at 3 GHz", BenchTicksToNs (&Fast, 1800000000000ULL), 600000000000ULL);
+  Check ("TicksToNs 3 GHz remainder", BenchTicksToNs (&Fast, 3000000001ULL), 1000000000);
+  Check ("TicksToNs no frequency", BenchTicksToNs (&Broken, 1234), 0);
+}
+
+STATIC
+VOID
+TestRates (
+  VOID
+  )
+{
+  UINT64 Whole;
+  UINT32 Hundredths;
+
+  Check ("RateKiB 1 MiB/s", BenchRateKiB (SIZE_1MB, 1000000000), 1024);
+  Check ("RateKiB 1 GiB in 0.5 s", BenchRateKiB (SIZE_1GB, 500000000), 2097152);
+  Check ("RateKiB 4 KiB in 1 us", BenchRateKiB (SIZE_4KB, 1000), 4000000);
+  Check ("RateKiB sub-KiB bytes", BenchRateKiB (1023, 1000000000), 0);
+  Check ("RateKiB no time", BenchRateKiB (SIZE_1MB, 0), 0);
+  /* Past one second the rate is computed at microsecond resolution */
+  Check ("RateKiB 64 GiB in 10 s", BenchRateKiB (64ULL * SIZE_1GB, 10000000000ULL), 6710886);
+  Check ("RateKiB 1 TiB in 1000 s", BenchRateKiB (1024ULL * SIZE_1GB, 1000000000000ULL), 1073741);
+
+  Check ("OpsPerSecond 1000 in 1 ms", BenchOpsPerSecond (1000, 1000000), 1000000);
+  Check ("OpsPerSecond 3 in 2 s", BenchOpsPerSecond (3, 2000000000), 1);
+  Check ("OpsPerSecond no time", BenchOpsPerSecond (3, 0), 0);
+
+  BenchSplitMiB (1536, &Whole, &Hundredths);
+  Check ("SplitMiB 1.5 whole", Whole, 1);
+  Check ("SplitMiB 1.5 hundredths", Hundredths, 50);
+  BenchSplitMiB (1023, &Whole, &Hundredths);
+  Check ("SplitMiB 1023 KiB whole", Whole, 0);
+  Check ("SplitMiB 1023 KiB hundredths", Hundredths, 99);
+  BenchSplitMiB (2097152, &Whole, &Hundredths);
+  Check ("SplitMiB 2 GiB whole", Whole, 2048);
+  Check ("SplitMiB 2 GiB hundredths", Hundredths, 0);
+}
+
+STATIC
+VOID
+TestRandom (
+  VOID
+  )
+{
+  UINT64 State;
+  UINTN Index;
+
+  /* Marsaglia's xorshift64 with shifts 13, 7, 17 */
+  State = 1;
+  Check ("Random 1st", BenchRandom (&State), 0x40822041ULL);
+  Check ("Random 2nd", BenchRandom (&State), 0x100041060C011441ULL);
+  Check ("Random 3rd", BenchRandom (&State), 0x9B1E842F6E862629ULL);
+  Check ("Random state", State, 0x9B1E842F6E862629ULL);
+
+  State = BENCH_RANDOM_SEED;
+  Check ("Random seed", BenchRandom (&State), 0xDC1B77AE0BF34DADULL);
+
+  /* A non-zero state never reaches zero, which would stick there */
+  for (Index = 0; Index < 1000000 && State != 0; Index++) {
+    BenchRandom (&State);
+  }
+  Check ("Random stays non-zero", State != 0, TRUE);
+}
+
+int
+main (
+  VOID
+  )
+{
+  TestElapsedTicks ();
+  TestTicksToNs ();
+  TestRates ();
+  TestRandom ();
+
+  printf ("BenchMath: %lu checks, %lu failures\n",
+          (unsigned long)mChecks, (unsigned long)mFailures);
+
+  return mFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
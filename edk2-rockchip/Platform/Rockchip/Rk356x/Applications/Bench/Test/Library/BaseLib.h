@@ -0,0 +1,71 @@
+/** @file
+ *
+ *  The BaseLib math helpers used by BenchMath.c, in plain C for
+ *  BenchMathTest.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#ifndef _BENCH_TEST_BASE_LIB_H_
+#define _BENCH_TEST_BASE_LIB_H_
+
+#include <Base.h>
+
+STATIC inline
+UINT64
+LShiftU64 (
+  IN UINT64  Operand,
+  IN UINTN   Count
+  )
+{
+  return Operand << Count;
+}
+
+STATIC inline
+UINT64
+RShiftU64 (
+  IN UINT64  Operand,
+  IN UINTN   Count
+  )
+{
+  return Operand >> Count;
+}
+
+STATIC inline
+UINT64
+MultU64x32 (
+  IN UINT64  Multiplicand,
+  IN UINT32  Multiplier
+  )
+{
+  return Multiplicand * Multiplier;
+}
+
+STATIC inline
+UINT64
+DivU64x32 (
+  IN UINT64  Dividend,
+  IN UINT32  Divisor
+  )
+{
+  return Dividend / Divisor;
+}
+
+STATIC inline
+UINT64
+DivU64x64Remainder (
+  IN  UINT64  Dividend,
+  IN  UINT64  Divisor,
+  OUT UINT64  *Remainder
+  )
+{
+  if (Remainder != NULL) {
+    *Remainder = Dividend % Divisor;
+  }
+  return Dividend / Divisor;
+}
+
+#endif /* _BENCH_TEST_BASE_LIB_H_ */
@@ -0,0 +1,118 @@
+/** @file
+ *
+ *  Dump the PMU profiling regions collected by PmuProfileLib.
+ *
+ *  pmuprofile            Print every region with its cycle histogram.
+ *  pmuprofile -r         Print, then reset the counts.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PmuProfileLib.h>
+#include <Library/ShellLib.h>
+#include <Library/UefiLib.h>
+
+STATIC CONST SHELL_PARAM_ITEM mParamList[] = {
+  { L"-r", TypeFlag },
+  { NULL, TypeMax }
+};
+
+STATIC
+VOID
+PmuProfileDumpRegion (
+  IN PMU_PROFILE_TABLE   *Table,
+  IN PMU_PROFILE_REGION  *Region
+  )
+{
+  UINTN Index;
+  UINTN Event;
+
+  Print (L"%a\n", Region->Name);
+  if (Region->Count == 0) {
+    Print (L"  never completed\n");
+    return;
+  }
+
+  Print (L"  calls %lu, cycles total %lu avg %lu min %lu max %lu\n",
+    Region->Count, Region->TotalCycles,
+    DivU64x64Remainder (Region->TotalCycles, Region->Count, NULL),
+    Region->MinCycles, Region->MaxCycles);
+  for (Event = 0; Event < PMU_PROFILE_EVENTS; Event++) {
+    Print (L"  event 0x%02x total %lu avg %lu\n", Table->Events[Event],
+      Region->TotalEvents[Event],
+      DivU64x64Remainder (Region->TotalEvents[Event], Region->Count, NULL));
+  }
+  for (Index = 0; Index < PMU_PROFILE_BUCKETS; Index++) {
+    if (Region->Histogram[Index] != 0) {
+      Print (L"  %s2^%-2u cycles: %u\n",
+        Index == PMU_PROFILE_BUCKETS - 1 ? L">=" : L"  ",
+        (UINT32)Index, Region->Histogram[Index]);
+    }
+  }
+}
+
+STATIC
+VOID
+PmuProfileResetRegion (
+  IN PMU_PROFILE_REGION  *Region
+  )
+{
+  Region->Count = 0;
+  Region->TotalCycles = 0;
+  Region->MinCycles = MAX_UINT64;
+  Region->MaxCycles = 0;
+  ZeroMem (Region->TotalEvents, sizeof (Region->TotalEvents));
+  ZeroMem (Region->Histogram, sizeof (Region->Histogram));
+}
+
+EFI_STATUS
+EFIAPI
+PmuProfileMain (
+  IN EFI_HANDLE         ImageHandle,
+  IN EFI_SYSTEM_TABLE   *SystemTable
+  )
+{
+  EFI_STATUS Status;
+  LIST_ENTRY *Package;
+  CHAR16 *ProblemParam;
+  PMU_PROFILE_TABLE *Table;
+  UINTN Index;
+
+  Status = ShellCommandLineParse (mParamList, &Package, &ProblemParam, TRUE);
+  if (EFI_ERROR (Status)) {
+    if (Status == EFI_VOLUME_CORRUPTED && ProblemParam != NULL) {
+      Print (L"pmuprofile: unknown option %s\n", ProblemParam);
+      FreePool (ProblemParam);
+    }
+    return Status;
+  }
+
+  Status = EfiGetSystemConfigurationTable (&gRk356xPmuProfileTableGuid, (VOID **)&Table);
+  if (EFI_ERROR (Status) || Table->Signature != PMU_PROFILE_TABLE_SIGNATURE) {
+    Print (L"pmuprofile: no regions recorded (is PcdPmuProfileEnable set?)\n");
+    Status = EFI_NOT_FOUND;
+    goto Exit;
+  }
+
+  for (Index = 0; Index < Table->NumRegions; Index++) {
+    PmuProfileDumpRegion (Table, Table->Regions[Index]);
+  }
+
+  if (ShellCommandLineGetFlag (Package, L"-r")) {
+    for (Index = 0; Index < Table->NumRegions; Index++) {
+      PmuProfileResetRegion (Table->Regions[Index]);
+    }
+  }
+
+Exit:
+  ShellCommandLineFreeVarList (Package);
+  return Status;
+}
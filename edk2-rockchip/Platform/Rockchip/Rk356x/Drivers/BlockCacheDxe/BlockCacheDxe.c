@@ -0,0 +1,930 @@
+/** @file
+ *
+ *  Read-ahead block cache for boot media.
+ *
+ *  Loading a kernel and initrd through SimpleFileSystem turns into a long
+ *  series of small, mostly sequential BlockIo reads, each of which pays the
+ *  full command latency of the eMMC, SD or USB device underneath. This driver
+ *  hooks the BlockIo protocol of every physical block device, notices when
+ *  reads become sequential and then fetches whole read-ahead windows into a
+ *  small per-device cache, so the following reads are served from memory.
+ *
+ *  The cache never holds dirty data: writes, erases and resets invalidate
+ *  the affected windows before being passed to the device.
+ *
+ *  UEFI has no notification for a protocol going away, so the uninstall and
+ *  reinstall boot services are wrapped as well. When a device driver takes
+ *  its BlockIo down, the cache puts the original functions back and frees
+ *  the entry before the driver releases the structure.
+ *
+ *  The list, the windows and the LRU state are only touched at TPL_NOTIFY.
+ *  Calls into the device drivers are made at the caller's TPL, as BlockIo
+ *  may not be used above TPL_CALLBACK.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+
+#include <Protocol/BlockIo.h>
+#include <Protocol/BlockIo2.h>
+#include <Protocol/DevicePath.h>
+#include <Protocol/EraseBlock.h>
+
+/* Size of a single read-ahead request */
+#define BLOCK_CACHE_WINDOW_SIZE     SIZE_256KB
+/* Number of windows cached per device */
+#define BLOCK_CACHE_WINDOWS         16
+/* Back-to-back sequential reads needed before read-ahead starts */
+#define BLOCK_CACHE_SEQ_THRESHOLD   2
+/* Reads at least this large already make good use of the device */
+#define BLOCK_CACHE_BYPASS_SIZE     BLOCK_CACHE_WINDOW_SIZE
+
+#define BLOCK_CACHE_EMPTY           MAX_UINT64
+
+#define BLOCK_CACHE_SIGNATURE       SIGNATURE_32 ('B', 'c', 'c', 'h')
+
+typedef struct {
+  EFI_LBA       Window;         // Window index, or BLOCK_CACHE_EMPTY
+  UINTN         Blocks;         // Valid blocks, short at the end of the media
+  UINT64        LastUse;
+  UINT8         *Data;
+  BOOLEAN       Filling;        // Being read from the device with the lock dropped
+  BOOLEAN       Stale;          // Invalidated while filling
+  EFI_LBA       Pending;        // Window being filled
+} BLOCK_CACHE_WINDOW;
+
+typedef struct {
+  UINT32                  Signature;
+  LIST_ENTRY              Link;
+
+  EFI_BLOCK_IO_PROTOCOL   *BlockIo;
+  EFI_BLOCK_IO2_PROTOCOL  *BlockIo2;
+  EFI_ERASE_BLOCK_PROTOCOL *EraseBlock;
+  EFI_BLOCK_RESET         Reset;
+  EFI_BLOCK_READ          ReadBlocks;
+  EFI_BLOCK_WRITE         WriteBlocks;
+  EFI_BLOCK_RESET_EX      ResetEx;
+  EFI_BLOCK_WRITE_EX      WriteBlocksEx;
+  EFI_BLOCK_ERASE         EraseBlocks;
+
+  CHAR16                  *Name;
+  UINT32                  MediaId;
+  UINTN                   WindowBlocks;
+  EFI_LBA                 NextLba;
+  UINTN                   SeqCount;
+  UINT64                  Clock;
+  BOOLEAN                 Disabled;
+  UINT8                   *Buffer;
+  BLOCK_CACHE_WINDOW      Windows[BLOCK_CACHE_WINDOWS];
+
+  UINT64                  Lookups;
+  UINT64                  Hits;
+  UINT64                  ReadAheads;
+  UINT64                  ReadAheadBytes;
+  UINT64                  Bypassed;
+  UINT64                  Invalidations;
+} BLOCK_CACHE;
+
+#define BLOCK_CACHE_FROM_LINK(a) CR (a, BLOCK_CACHE, Link, BLOCK_CACHE_SIGNATURE)
+
+STATIC LIST_ENTRY mBlockCacheList = INITIALIZE_LIST_HEAD_VARIABLE (mBlockCacheList);
+STATIC VOID *mBlockIoRegistration;
+STATIC EFI_UNINSTALL_PROTOCOL_INTERFACE mUninstallProtocolInterface;
+STATIC EFI_REINSTALL_PROTOCOL_INTERFACE mReinstallProtocolInterface;
+
+STATIC
+BLOCK_CACHE *
+BlockCacheFind (
+  IN VOID   *Protocol
+  )
+{
+  LIST_ENTRY *Link;
+  BLOCK_CACHE *Cache;
+
+  for (Link = GetFirstNode (&mBlockCacheList);
+       !IsNull (&mBlockCacheList, Link);
+       Link = GetNextNode (&mBlockCacheList, Link)) {
+    Cache = BLOCK_CACHE_FROM_LINK (Link);
+    if (Cache->BlockIo == Protocol ||
+        (Cache->BlockIo2 != NULL && Cache->BlockIo2 == Protocol) ||
+        (Cache->EraseBlock != NULL && Cache->EraseBlock == Protocol)) {
+      return Cache;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Drop cached windows overlapping a range of blocks.
+
+  @param[in]  Cache             The device cache.
+  @param[in]  Lba               First block of the range.
+  @param[in]  Blocks            Number of blocks, or 0 to drop everything.
+
+**/
+STATIC
+VOID
+BlockCacheInvalidate (
+  IN BLOCK_CACHE  *Cache,
+  IN EFI_LBA      Lba,
+  IN UINTN        Blocks
+  )
+{
+  EFI_LBA First;
+  EFI_LBA Last;
+  UINTN Index;
+
+  First = DivU64x64Remainder (Lba, Cache->WindowBlocks, NULL);
+  Last = DivU64x64Remainder (Lba + Blocks - 1, Cache->WindowBlocks, NULL);
+
+  for (Index = 0; Index < BLOCK_CACHE_WINDOWS; Index++) {
+    if (Cache->Windows[Index].Filling &&
+        (Blocks == 0 ||
+         (Cache->Windows[Index].Pending >= First &&
+          Cache->Windows[Index].Pending <= Last))) {
+      Cache->Windows[Index].Stale = TRUE;
+    }
+    if (Cache->Windows[Index].Window == BLOCK_CACHE_EMPTY) {
+      continue;
+    }
+    if (Blocks == 0 ||
+        (Cache->Windows[Index].Window >= First &&
+         Cache->Windows[Index].Window <= Last)) {
+      Cache->Windows[Index].Window = BLOCK_CACHE_EMPTY;
+      Cache->Invalidations++;
+    }
+  }
+
+  Cache->SeqCount = 0;
+}
+
+/**
+  Drop the whole cache if the media has changed underneath us.
+
+  @param[in]  Cache             The device cache.
+
+**/
+STATIC
+VOID
+BlockCacheCheckMedia (
+  IN BLOCK_CACHE  *Cache
+  )
+{
+  EFI_BLOCK_IO_MEDIA *Media;
+
+  Media = Cache->BlockIo->Media;
+  if (!Media->MediaPresent || Media->MediaId != Cache->MediaId) {
+    BlockCacheInvalidate (Cache, 0, 0);
+    Cache->MediaId = Media->MediaId;
+    Cache->NextLba = 0;
+  }
+}
+
+STATIC
+BLOCK_CACHE_WINDOW *
+BlockCacheLookup (
+  IN BLOCK_CACHE  *Cache,
+  IN EFI_LBA      Window
+  )
+{
+  UINTN Index;
+
+  for (Index = 0; Index < BLOCK_CACHE_WINDOWS; Index++) {
+    if (Cache->Windows[Index].Window == Window) {
+      Cache->Windows[Index].LastUse = ++Cache->Clock;
+      return &Cache->Windows[Index];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Read a whole window from the device into the least recently used slot.
+
+  Called at TPL_NOTIFY. The TPL is dropped back to the caller's for the
+  device read; the slot is marked as filling meanwhile so that nothing else
+  claims it, and any invalidation of the window in that time discards the
+  result.
+
+  @param[in]  Cache             The device cache.
+  @param[in]  MediaId           The media ID the caller passed in.
+  @param[in]  Window            The window to fetch.
+  @param[in]  Tpl               The caller's TPL.
+
+  @retval  The filled slot, or NULL if no slot was free or the read failed.
+
+**/
+STATIC
+BLOCK_CACHE_WINDOW *
+BlockCacheFill (
+  IN BLOCK_CACHE  *Cache,
+  IN UINT32       MediaId,
+  IN EFI_LBA      Window,
+  IN EFI_TPL      Tpl
+  )
+{
+  EFI_BLOCK_IO_MEDIA *Media;
+  BLOCK_CACHE_WINDOW *Slot;
+  EFI_STATUS Status;
+  EFI_LBA Lba;
+  UINTN Index;
+
+  Media = Cache->BlockIo->Media;
+
+  Slot = NULL;
+  for (Index = 0; Index < BLOCK_CACHE_WINDOWS; Index++) {
+    if (Cache->Windows[Index].Filling) {
+      continue;
+    }
+    if (Cache->Windows[Index].Window == BLOCK_CACHE_EMPTY) {
+      Slot = &Cache->Windows[Index];
+      break;
+    }
+    if (Slot == NULL || Cache->Windows[Index].LastUse < Slot->LastUse) {
+      Slot = &Cache->Windows[Index];
+    }
+  }
+  if (Slot == NULL) {
+    return NULL;
+  }
+
+  Lba = MultU64x32 (Window, (UINT32)Cache->WindowBlocks);
+  Slot->Window = BLOCK_CACHE_EMPTY;
+  Slot->Blocks = (UINTN)MIN ((UINT64)Cache->WindowBlocks, Media->LastBlock + 1 - Lba);
+  Slot->Filling = TRUE;
+  Slot->Stale = FALSE;
+  Slot->Pending = Window;
+
+  gBS->RestoreTPL (Tpl);
+  Status = Cache->ReadBlocks (Cache->BlockIo, MediaId, Lba,
+                              Slot->Blocks * Media->BlockSize, Slot->Data);
+  gBS->RaiseTPL (TPL_NOTIFY);
+
+  Slot->Filling = FALSE;
+  if (EFI_ERROR (Status) || Slot->Stale) {
+    return NULL;
+  }
+
+  Slot->Window = Window;
+  Slot->LastUse = ++Cache->Clock;
+  Cache->ReadAheads++;
+  Cache->ReadAheadBytes += Slot->Blocks * Media->BlockSize;
+
+  return Slot;
+}
+
+/**
+  Allocate the window buffers the first time a device sees sequential reads.
+
+  @param[in]  Cache             The device cache.
+
+  @retval  TRUE if the cache is usable.
+
+**/
+STATIC
+BOOLEAN
+BlockCacheAllocate (
+  IN BLOCK_CACHE  *Cache
+  )
+{
+  UINTN Index;
+
+  if (Cache->Buffer != NULL) {
+    return TRUE;
+  }
+  if (Cache->Disabled) {
+    return FALSE;
+  }
+
+  Cache->Buffer = AllocatePages (EFI_SIZE_TO_PAGES (BLOCK_CACHE_WINDOW_SIZE * BLOCK_CACHE_WINDOWS));
+  if (Cache->Buffer == NULL) {
+    DEBUG ((DEBUG_WARN, "BlockCacheDxe: Out of memory, no read-ahead for %s\n", Cache->Name));
+    Cache->Disabled = TRUE;
+    return FALSE;
+  }
+
+  for (Index = 0; Index < BLOCK_CACHE_WINDOWS; Index++) {
+    Cache->Windows[Index].Window = BLOCK_CACHE_EMPTY;
+    Cache->Windows[Index].Data = Cache->Buffer + Index * BLOCK_CACHE_WINDOW_SIZE;
+  }
+
+  return TRUE;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+BlockCacheReset (
+  IN EFI_BLOCK_IO_PROTOCOL  *This,
+  IN BOOLEAN                ExtendedVerification
+  )
+{
+  BLOCK_CACHE *Cache;
+  EFI_BLOCK_RESET Reset;
+  EFI_TPL OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Cache = BlockCacheFind (This);
+  ASSERT (Cache != NULL);
+  Reset = Cache->Reset;
+  BlockCacheInvalidate (Cache, 0, 0);
+  gBS->RestoreTPL (OldTpl);
+
+  return Reset (This, ExtendedVerification);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+BlockCacheReadBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This,
+  IN UINT32                 MediaId,
+  IN EFI_LBA                Lba,
+  IN UINTN                  BufferSize,
+  OUT VOID                  *Buffer
+  )
+{
+  BLOCK_CACHE *Cache;
+  BLOCK_CACHE_WINDOW *Slot;
+  EFI_BLOCK_IO_MEDIA *Media;
+  EFI_BLOCK_READ ReadBlocks;
+  EFI_STATUS Status;
+  EFI_TPL OldTpl;
+  EFI_LBA Window;
+  UINTN Offset;
+  UINTN Blocks;
+  UINTN Count;
+  UINT8 *Dest;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Cache = BlockCacheFind (This);
+  ASSERT (Cache != NULL);
+  ReadBlocks = Cache->ReadBlocks;
+
+  Media = This->Media;
+  BlockCacheCheckMedia (Cache);
+
+  // Leave argument checking to the driver underneath.
+  if (MediaId != Media->MediaId || Buffer == NULL || BufferSize == 0 ||
+      (BufferSize % Media->BlockSize) != 0 || Lba > Media->LastBlock ||
+      (BufferSize / Media->BlockSize) - 1 > Media->LastBlock - Lba) {
+    gBS->RestoreTPL (OldTpl);
+    return ReadBlocks (This, MediaId, Lba, BufferSize, Buffer);
+  }
+
+  Blocks = BufferSize / Media->BlockSize;
+  Cache->SeqCount = (Lba == Cache->NextLba) ? Cache->SeqCount + 1 : 0;
+  Cache->NextLba = Lba + Blocks;
+
+  if (BufferSize >= BLOCK_CACHE_BYPASS_SIZE) {
+    Cache->Bypassed++;
+    gBS->RestoreTPL (OldTpl);
+    return ReadBlocks (This, MediaId, Lba, BufferSize, Buffer);
+  }
+
+  Dest = Buffer;
+  Status = EFI_SUCCESS;
+  while (Blocks > 0) {
+    Window = DivU64x64Remainder (Lba, Cache->WindowBlocks, NULL);
+    Offset = (UINTN)(Lba - MultU64x32 (Window, (UINT32)Cache->WindowBlocks));
+    Count = MIN (Blocks, Cache->WindowBlocks - Offset);
+
+    Slot = NULL;
+    if (Cache->Buffer != NULL) {
+      Cache->Lookups++;
+      Slot = BlockCacheLookup (Cache, Window);
+      if (Slot != NULL) {
+        Cache->Hits++;
+      }
+    }
+    if (Slot == NULL && Cache->SeqCount >= BLOCK_CACHE_SEQ_THRESHOLD &&
+        BlockCacheAllocate (Cache)) {
+      Slot = BlockCacheFill (Cache, MediaId, Window, OldTpl);
+    }
+
+    if (Slot != NULL) {
+      CopyMem (Dest, Slot->Data + Offset * Media->BlockSize, Count * Media->BlockSize);
+    } else {
+      gBS->RestoreTPL (OldTpl);
+      Status = ReadBlocks (This, MediaId, Lba, Count * Media->BlockSize, Dest);
+      gBS->RaiseTPL (TPL_NOTIFY);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    }
+
+    Lba += Count;
+    Blocks -= Count;
+    Dest += Count * Media->BlockSize;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+BlockCacheWriteBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This,
+  IN UINT32                 MediaId,
+  IN EFI_LBA                Lba,
+  IN UINTN                  BufferSize,
+  IN VOID                   *Buffer
+  )
+{
+  BLOCK_CACHE *Cache;
+  EFI_BLOCK_WRITE WriteBlocks;
+  EFI_TPL OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Cache = BlockCacheFind (This);
+  ASSERT (Cache != NULL);
+  WriteBlocks = Cache->WriteBlocks;
+  BlockCacheCheckMedia (Cache);
+  if (BufferSize >= This->Media->BlockSize) {
+    BlockCacheInvalidate (Cache, Lba, BufferSize / This->Media->BlockSize);
+  }
+  gBS->RestoreTPL (OldTpl);
+
+  return WriteBlocks (This, MediaId, Lba, BufferSize, Buffer);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+BlockCacheResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN BOOLEAN                 ExtendedVerification
+  )
+{
+  BLOCK_CACHE *Cache;
+  EFI_BLOCK_RESET_EX ResetEx;
+  EFI_TPL OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Cache = BlockCacheFind (This);
+  ASSERT (Cache != NULL);
+  ResetEx = Cache->ResetEx;
+  BlockCacheInvalidate (Cache, 0, 0);
+  gBS->RestoreTPL (OldTpl);
+
+  return ResetEx (This, ExtendedVerification);
+}
+
+/*
+ * Asynchronous reads go straight to the device, but writes through BlockIo2
+ * still have to invalidate what was cached via BlockIo.
+ */
+STATIC
+EFI_STATUS
+EFIAPI
+BlockCacheWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN     UINT32                  MediaId,
+  IN     EFI_LBA                 Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token,
+  IN     UINTN                   BufferSize,
+  IN     VOID                    *Buffer
+  )
+{
+  BLOCK_CACHE *Cache;
+  EFI_BLOCK_WRITE_EX WriteBlocksEx;
+  EFI_TPL OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Cache = BlockCacheFind (This);
+  ASSERT (Cache != NULL);
+  WriteBlocksEx = Cache->WriteBlocksEx;
+  BlockCacheCheckMedia (Cache);
+  if (BufferSize >= This->Media->BlockSize) {
+    BlockCacheInvalidate (Cache, Lba, BufferSize / This->Media->BlockSize);
+  }
+  gBS->RestoreTPL (OldTpl);
+
+  return WriteBlocksEx (This, MediaId, Lba, Token, BufferSize, Buffer);
+}
+
+/*
+ * Erased blocks read back as zeroes or ones depending on the device, so
+ * they are dropped from the cache just like written ones.
+ */
+STATIC
+EFI_STATUS
+EFIAPI
+BlockCacheEraseBlocks (
+  IN     EFI_ERASE_BLOCK_PROTOCOL  *This,
+  IN     UINT32                    MediaId,
+  IN     EFI_LBA                   Lba,
+  IN OUT EFI_ERASE_BLOCK_TOKEN     *Token,
+  IN     UINTN                     Size
+  )
+{
+  BLOCK_CACHE *Cache;
+  EFI_BLOCK_ERASE EraseBlocks;
+  EFI_TPL OldTpl;
+  UINT32 BlockSize;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Cache = BlockCacheFind (This);
+  ASSERT (Cache != NULL);
+  EraseBlocks = Cache->EraseBlocks;
+  BlockCacheCheckMedia (Cache);
+  BlockSize = Cache->BlockIo->Media->BlockSize;
+  if (Size > 0) {
+    BlockCacheInvalidate (Cache, Lba, (Size + BlockSize - 1) / BlockSize);
+  }
+  gBS->RestoreTPL (OldTpl);
+
+  return EraseBlocks (This, MediaId, Lba, Token, Size);
+}
+
+STATIC
+BOOLEAN
+IsRamDisk (
+  IN EFI_DEVICE_PATH_PROTOCOL  *DevicePath
+  )
+{
+  while (!IsDevicePathEnd (DevicePath)) {
+    if (DevicePathType (DevicePath) == MEDIA_DEVICE_PATH &&
+        DevicePathSubType (DevicePath) == MEDIA_RAM_DISK_DP) {
+      return TRUE;
+    }
+    DevicePath = NextDevicePathNode (DevicePath);
+  }
+
+  return FALSE;
+}
+
+/**
+  Put a cache in front of a newly installed block device.
+
+  Partition and disk I/O drivers call through the device's own BlockIo
+  structure, so the function pointers are swapped in place rather than
+  reinstalling the protocol; this keeps the device driver's Stop path
+  working unchanged.
+
+  @param[in]  Handle            The handle carrying the BlockIo protocol.
+
+**/
+STATIC
+VOID
+BlockCacheHook (
+  IN EFI_HANDLE  Handle
+  )
+{
+  EFI_STATUS Status;
+  EFI_BLOCK_IO_PROTOCOL *BlockIo;
+  EFI_BLOCK_IO2_PROTOCOL *BlockIo2;
+  EFI_ERASE_BLOCK_PROTOCOL *EraseBlock;
+  EFI_DEVICE_PATH_PROTOCOL *DevicePath;
+  BLOCK_CACHE *Cache;
+  UINT32 BlockSize;
+  EFI_TPL OldTpl;
+
+  Status = gBS->HandleProtocol (Handle, &gEfiBlockIoProtocolGuid, (VOID **)&BlockIo);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+  if (BlockIo->ReadBlocks == BlockCacheReadBlocks) {
+    return;
+  }
+  if (BlockIo->Media->LogicalPartition) {
+    return;
+  }
+
+  BlockSize = BlockIo->Media->BlockSize;
+  if (BlockSize == 0 || BlockSize > BLOCK_CACHE_WINDOW_SIZE ||
+      (BlockSize & (BlockSize - 1)) != 0 ||
+      BlockIo->Media->IoAlign > EFI_PAGE_SIZE) {
+    return;
+  }
+
+  Status = gBS->HandleProtocol (Handle, &gEfiDevicePathProtocolGuid, (VOID **)&DevicePath);
+  if (EFI_ERROR (Status) || IsRamDisk (DevicePath)) {
+    return;
+  }
+
+  Cache = AllocateZeroPool (sizeof (BLOCK_CACHE));
+  if (Cache == NULL) {
+    return;
+  }
+
+  Cache->Signature = BLOCK_CACHE_SIGNATURE;
+  Cache->BlockIo = BlockIo;
+  Cache->Name = ConvertDevicePathToText (DevicePath, FALSE, TRUE);
+  Cache->MediaId = BlockIo->Media->MediaId;
+  Cache->WindowBlocks = BLOCK_CACHE_WINDOW_SIZE / BlockSize;
+  Cache->NextLba = BLOCK_CACHE_EMPTY;
+
+  Status = gBS->HandleProtocol (Handle, &gEfiBlockIo2ProtocolGuid, (VOID **)&BlockIo2);
+  if (EFI_ERROR (Status) || BlockIo2->WriteBlocksEx == BlockCacheWriteBlocksEx) {
+    BlockIo2 = NULL;
+  }
+  Status = gBS->HandleProtocol (Handle, &gEfiEraseBlockProtocolGuid, (VOID **)&EraseBlock);
+  if (EFI_ERROR (Status) || EraseBlock->EraseBlocks == BlockCacheEraseBlocks) {
+    EraseBlock = NULL;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  // Entries are dropped when their BlockIo is uninstalled, never reused.
+  ASSERT (BlockCacheFind (BlockIo) == NULL);
+
+  Cache->Reset = BlockIo->Reset;
+  Cache->ReadBlocks = BlockIo->ReadBlocks;
+  Cache->WriteBlocks = BlockIo->WriteBlocks;
+  BlockIo->Reset = BlockCacheReset;
+  BlockIo->ReadBlocks = BlockCacheReadBlocks;
+  BlockIo->WriteBlocks = BlockCacheWriteBlocks;
+
+  if (BlockIo2 != NULL) {
+    Cache->BlockIo2 = BlockIo2;
+    Cache->ResetEx = BlockIo2->Reset;
+    Cache->WriteBlocksEx = BlockIo2->WriteBlocksEx;
+    BlockIo2->Reset = BlockCacheResetEx;
+    BlockIo2->WriteBlocksEx = BlockCacheWriteBlocksEx;
+  }
+
+  if (EraseBlock != NULL) {
+    Cache->EraseBlock = EraseBlock;
+    Cache->EraseBlocks = EraseBlock->EraseBlocks;
+    EraseBlock->EraseBlocks = BlockCacheEraseBlocks;
+  }
+
+  InsertTailList (&mBlockCacheList, &Cache->Link);
+  gBS->RestoreTPL (OldTpl);
+
+  DEBUG ((DEBUG_INFO, "BlockCacheDxe: Caching %s\n", Cache->Name));
+}
+
+STATIC
+VOID
+EFIAPI
+BlockCacheOnBlockIoInstall (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_STATUS Status;
+  EFI_HANDLE Handle;
+  UINTN BufferSize;
+
+  for (;;) {
+    BufferSize = sizeof (EFI_HANDLE);
+    Status = gBS->LocateHandle (ByRegisterNotify, NULL, mBlockIoRegistration,
+                    &BufferSize, &Handle);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    BlockCacheHook (Handle);
+  }
+}
+
+/**
+  Take the cache out from in front of a device and free it.
+
+  @param[in]  Cache             The device cache.
+
+**/
+STATIC
+VOID
+BlockCacheRemove (
+  IN BLOCK_CACHE  *Cache
+  )
+{
+  Cache->BlockIo->Reset = Cache->Reset;
+  Cache->BlockIo->ReadBlocks = Cache->ReadBlocks;
+  Cache->BlockIo->WriteBlocks = Cache->WriteBlocks;
+  if (Cache->BlockIo2 != NULL) {
+    Cache->BlockIo2->Reset = Cache->ResetEx;
+    Cache->BlockIo2->WriteBlocksEx = Cache->WriteBlocksEx;
+  }
+  if (Cache->EraseBlock != NULL) {
+    Cache->EraseBlock->EraseBlocks = Cache->EraseBlocks;
+  }
+
+  RemoveEntryList (&Cache->Link);
+  if (Cache->Buffer != NULL) {
+    FreePages (Cache->Buffer, EFI_SIZE_TO_PAGES (BLOCK_CACHE_WINDOW_SIZE * BLOCK_CACHE_WINDOWS));
+  }
+  if (Cache->Name != NULL) {
+    FreePool (Cache->Name);
+  }
+  FreePool (Cache);
+}
+
+/**
+  Let go of a protocol interface that has just been uninstalled.
+
+  The BlockIo2 and EraseBlock hooks are undone on their own, since a driver
+  may take those down separately. Losing the BlockIo drops the whole entry.
+
+  @param[in]  Protocol          The protocol GUID.
+  @param[in]  Interface         The interface that is gone.
+
+**/
+STATIC
+VOID
+BlockCacheForget (
+  IN EFI_GUID  *Protocol,
+  IN VOID      *Interface
+  )
+{
+  BLOCK_CACHE *Cache;
+
+  Cache = BlockCacheFind (Interface);
+  if (Cache == NULL) {
+    return;
+  }
+
+  if (Interface == Cache->BlockIo &&
+      CompareGuid (Protocol, &gEfiBlockIoProtocolGuid)) {
+    DEBUG ((DEBUG_INFO, "BlockCacheDxe: Dropping %s\n", Cache->Name));
+    BlockCacheRemove (Cache);
+  } else if (Interface == Cache->BlockIo2 &&
+             CompareGuid (Protocol, &gEfiBlockIo2ProtocolGuid)) {
+    Cache->BlockIo2->Reset = Cache->ResetEx;
+    Cache->BlockIo2->WriteBlocksEx = Cache->WriteBlocksEx;
+    Cache->BlockIo2 = NULL;
+  } else if (Interface == Cache->EraseBlock &&
+             CompareGuid (Protocol, &gEfiEraseBlockProtocolGuid)) {
+    Cache->EraseBlock->EraseBlocks = Cache->EraseBlocks;
+    Cache->EraseBlock = NULL;
+  }
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+BlockCacheUninstallProtocolInterface (
+  IN EFI_HANDLE  Handle,
+  IN EFI_GUID    *Protocol,
+  IN VOID        *Interface
+  )
+{
+  EFI_STATUS Status;
+  EFI_TPL OldTpl;
+
+  // Drivers above still call through the hooks while they are disconnected.
+  Status = mUninstallProtocolInterface (Handle, Protocol, Interface);
+  if (!EFI_ERROR (Status)) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    BlockCacheForget (Protocol, Interface);
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  return Status;
+}
+
+/*
+ * The variable argument list cannot be handed on to the original service,
+ * so this repeats what the DXE core does: uninstall the interfaces one at a
+ * time, and put back the ones already removed if any of them fails.
+ */
+STATIC
+EFI_STATUS
+EFIAPI
+BlockCacheUninstallMultipleProtocolInterfaces (
+  IN EFI_HANDLE  Handle,
+  ...
+  )
+{
+  EFI_STATUS Status;
+  VA_LIST Args;
+  EFI_GUID *Protocol;
+  VOID *Interface;
+  UINTN Index;
+
+  VA_START (Args, Handle);
+  for (Index = 0, Status = EFI_SUCCESS; !EFI_ERROR (Status); Index++) {
+    Protocol = VA_ARG (Args, EFI_GUID *);
+    if (Protocol == NULL) {
+      break;
+    }
+    Interface = VA_ARG (Args, VOID *);
+    Status = BlockCacheUninstallProtocolInterface (Handle, Protocol, Interface);
+  }
+  VA_END (Args);
+
+  if (EFI_ERROR (Status)) {
+    VA_START (Args, Handle);
+    for ( ; Index > 1; Index--) {
+      Protocol = VA_ARG (Args, EFI_GUID *);
+      Interface = VA_ARG (Args, VOID *);
+      gBS->InstallProtocolInterface (&Handle, Protocol, EFI_NATIVE_INTERFACE, Interface);
+    }
+    VA_END (Args);
+    Status = EFI_INVALID_PARAMETER;
+  }
+
+  return Status;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+BlockCacheReinstallProtocolInterface (
+  IN EFI_HANDLE  Handle,
+  IN EFI_GUID    *Protocol,
+  IN VOID        *OldInterface,
+  IN VOID        *NewInterface
+  )
+{
+  EFI_STATUS Status;
+  EFI_TPL OldTpl;
+
+  // The new interface is picked up by the BlockIo install notification.
+  Status = mReinstallProtocolInterface (Handle, Protocol, OldInterface, NewInterface);
+  if (!EFI_ERROR (Status) && OldInterface != NewInterface) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    BlockCacheForget (Protocol, OldInterface);
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  return Status;
+}
+
+/**
+  Report how well the cache did for each device.
+
+  @param[in]  Event             The ExitBootServices event.
+  @param[in]  Context           Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+BlockCacheExitBootServices (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  LIST_ENTRY *Link;
+  BLOCK_CACHE *Cache;
+
+  for (Link = GetFirstNode (&mBlockCacheList);
+       !IsNull (&mBlockCacheList, Link);
+       Link = GetNextNode (&mBlockCacheList, Link)) {
+    Cache = BLOCK_CACHE_FROM_LINK (Link);
+    if (Cache->Lookups == 0 && Cache->Bypassed == 0) {
+      continue;
+    }
+    DEBUG ((DEBUG_INFO, "BlockCacheDxe: %s\n", Cache->Name));
+    DEBUG ((DEBUG_INFO, "BlockCacheDxe:   %lu/%lu lookups hit (%lu%%), %lu large reads bypassed\n",
+            Cache->Hits, Cache->Lookups,
+            Cache->Lookups == 0 ? 0 : DivU64x64Remainder (MultU64x32 (Cache->Hits, 100), Cache->Lookups, NULL),
+            Cache->Bypassed));
+    DEBUG ((DEBUG_INFO, "BlockCacheDxe:   %lu read-aheads (%lu KiB), %lu windows invalidated\n",
+            Cache->ReadAheads, RShiftU64 (Cache->ReadAheadBytes, 10),
+            Cache->Invalidations));
+  }
+}
+
+EFI_STATUS
+EFIAPI
+BlockCacheDxeInitialize (
+  IN EFI_HANDLE         ImageHandle,
+  IN EFI_SYSTEM_TABLE   *SystemTable
+  )
+{
+  EFI_STATUS Status;
+  EFI_EVENT Event;
+  EFI_TPL OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  mUninstallProtocolInterface = gBS->UninstallProtocolInterface;
+  mReinstallProtocolInterface = gBS->ReinstallProtocolInterface;
+  gBS->UninstallProtocolInterface = BlockCacheUninstallProtocolInterface;
+  gBS->UninstallMultipleProtocolInterfaces = BlockCacheUninstallMultipleProtocolInterfaces;
+  gBS->ReinstallProtocolInterface = BlockCacheReinstallProtocolInterface;
+  gBS->Hdr.CRC32 = 0;
+  gBS->CalculateCrc32 (gBS, gBS->Hdr.HeaderSize, &gBS->Hdr.CRC32);
+  gBS->RestoreTPL (OldTpl);
+
+  Event = EfiCreateProtocolNotifyEvent (&gEfiBlockIoProtocolGuid, TPL_CALLBACK,
+            BlockCacheOnBlockIoInstall, NULL, &mBlockIoRegistration);
+  if (Event == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = gBS->CreateEvent (EVT_SIGNAL_EXIT_BOOT_SERVICES, TPL_NOTIFY,
+                  BlockCacheExitBootServices, NULL, &Event);
+  ASSERT_EFI_ERROR (Status);
+
+  return EFI_SUCCESS;
+}
@@ -309,6 +309,57 @@ SetupVariables (
   }
 #endif
 
+  Size = sizeof (UINT32);
+  Status = gRT->GetVariable (L"EmmcBusMode",
+                             &gConfigDxeFormSetGuid,
+                             NULL, &Size, &Var32);
+  if (EFI_ERROR (Status)) {
+    Status = PcdSet32S (PcdEmmcBusMode, PcdGet32 (PcdEmmcBusMode));
+    ASSERT_EFI_ERROR (Status);
+  }
+
+  Size = sizeof (UINT32);
+  Status = gRT->GetVariable (L"EmmcClock",
+                             &gConfigDxeFormSetGuid,
+                             NULL, &Size, &Var32);
+  if (EFI_ERROR (Status)) {
+    Status = PcdSet32S (PcdEmmcClock, PcdGet32 (PcdEmmcClock));
+    ASSERT_EFI_ERROR (Status);
+  }
+
+  /*
+   * EmmcStatus is volatile and filled in by EmmcDxe once the card is
+   * initialized.
+   */
+  Size = sizeof (UINT32);
+  Status = gRT->GetVariable (L"EmmcStatus",
+                             &gConfigDxeFormSetGuid,
+                             NULL, &Size, &Var32);
+  if (EFI_ERROR (Status) && Status != EFI_BUFFER_TOO_SMALL) {
+    Status = PcdSet32S (PcdEmmcCurrentBusMode, PcdGet32 (PcdEmmcCurrentBusMode));
+    ASSERT_EFI_ERROR (Status);
+    Status = PcdSet32S (PcdEmmcCurrentClock, PcdGet32 (PcdEmmcCurrentClock));
+    ASSERT_EFI_ERROR (Status);
+  }
+
+  Size = sizeof (UINT32);
+  Status = gRT->GetVariable (L"DisplayPower",
+                             &gConfigDxeFormSetGuid,
+                             NULL, &Size, &Var32);
+  if (EFI_ERROR (Status)) {
+    Status = PcdSet32S (PcdDisplayPowerPolicy, PcdGet32 (PcdDisplayPowerPolicy));
+    ASSERT_EFI_ERROR (Status);
+  }
+
+  Size = sizeof (UINT32);
+  Status = gRT->GetVariable (L"DisplayColorDepth",
+                             &gConfigDxeFormSetGuid,
+                             NULL, &Size, &Var32);
+  if (EFI_ERROR (Status)) {
+    Status = PcdSet32S (PcdDisplayColorDepth, PcdGet32 (PcdDisplayColorDepth));
+    ASSERT_EFI_ERROR (Status);
+  }
+
 #if FAN_GPIO_BANK != 0xFF
   ASSERT (FAN_GPIO_PIN != 0xFF);
   Size = sizeof (BOOLEAN);
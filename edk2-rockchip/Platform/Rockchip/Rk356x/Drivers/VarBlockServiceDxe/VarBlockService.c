@@ -87,6 +87,134 @@ EFI_FW_VOL_BLOCK_DEVICE mFvbDeviceTemplate = {
 };
 
 
+VOID
+VarStoreMarkDirty (
+  IN UINTN Address,
+  IN UINTN Length
+  )
+{
+  UINTN Block;
+  UINTN LastBlock;
+
+  if (Length == 0) {
+    return;
+  }
+
+  Block = (Address - mFvInstance->FvBase) / VAR_STORE_DIRTY_BLOCK_SIZE;
+  LastBlock = (Address - mFvInstance->FvBase + Length - 1) / VAR_STORE_DIRTY_BLOCK_SIZE;
+  for (; Block <= LastBlock; Block++) {
+    mFvInstance->DirtyMap[Block / 8] |= (UINT8)(1U << (Block % 8));
+  }
+
+  mFvInstance->Dirty = TRUE;
+}
+
+
+BOOLEAN
+VarStoreIsBlockDirty (
+  IN UINTN Block
+  )
+{
+  UINTN Offset;
+
+  //
+  // The journal region is written explicitly by the flush code.
+  //
+  Offset = Block * VAR_STORE_DIRTY_BLOCK_SIZE;
+  if (Offset >= mFvInstance->JournalOffset &&
+      Offset < mFvInstance->JournalOffset + mFvInstance->JournalLength) {
+    return FALSE;
+  }
+
+  return (mFvInstance->DirtyMap[Block / 8] & (1U << (Block % 8))) != 0;
+}
+
+
+UINT32
+VarStoreJournalCrc (
+  IN VAR_STORE_JOURNAL_HEADER *Journal
+  )
+{
+  UINT32 Crc;
+  UINT32 SavedCrc;
+  UINTN Index;
+  UINTN Length;
+
+  SavedCrc = Journal->Crc32;
+  Journal->Crc32 = 0;
+
+  Length = VAR_STORE_DIRTY_BLOCK_SIZE;
+  for (Index = 0; Index < Journal->NumRuns; Index++) {
+    Length += Journal->Runs[Index].Length;
+  }
+  Crc = CalculateCrc32 (Journal, Length);
+
+  Journal->Crc32 = SavedCrc;
+  return Crc;
+}
+
+
+STATIC
+VOID
+VarStoreReplayJournal (
+  VOID
+  )
+{
+  VAR_STORE_JOURNAL_HEADER *Journal;
+  VAR_STORE_JOURNAL_RUN *Run;
+  UINT8 *Data;
+  UINTN Index;
+  UINTN Length;
+  UINT64 RunEnd;
+
+  Journal = (VAR_STORE_JOURNAL_HEADER*)(mFvInstance->FvBase + mFvInstance->JournalOffset);
+  if (Journal->Signature != VAR_STORE_JOURNAL_SIGNATURE) {
+    return;
+  }
+
+  //
+  // A valid journal means the last flush did not finish. The journal
+  // itself must be invalidated on the next flush either way.
+  //
+  mFvInstance->JournalStale = TRUE;
+  mFvInstance->JournalSequence = Journal->Sequence;
+
+  Length = VAR_STORE_DIRTY_BLOCK_SIZE;
+  for (Index = 0; Index < Journal->NumRuns && Index < VAR_STORE_JOURNAL_MAX_RUNS; Index++) {
+    Length += Journal->Runs[Index].Length;
+  }
+  if (Journal->NumRuns > VAR_STORE_JOURNAL_MAX_RUNS ||
+      Length > mFvInstance->JournalLength ||
+      Journal->Crc32 != VarStoreJournalCrc (Journal)) {
+    DEBUG ((DEBUG_WARN, "Variable store journal %u is torn, ignoring it\n",
+      Journal->Sequence));
+    return;
+  }
+
+  DEBUG ((DEBUG_WARN, "Variable store flush %u was interrupted, replaying %u run(s)\n",
+    Journal->Sequence, Journal->NumRuns));
+
+  Data = (UINT8*)Journal + VAR_STORE_DIRTY_BLOCK_SIZE;
+  for (Index = 0; Index < Journal->NumRuns; Index++) {
+    Run = &Journal->Runs[Index];
+    RunEnd = (UINT64)Run->Offset + Run->Length;
+
+    //
+    // Runs never overlap the journal region or extend past the store.
+    //
+    if (RunEnd > mFvInstance->FvLength ||
+        (RunEnd > mFvInstance->JournalOffset &&
+         Run->Offset < mFvInstance->JournalOffset + mFvInstance->JournalLength)) {
+      DEBUG ((DEBUG_ERROR, "Variable store journal run %u is out of range\n", Index));
+    } else {
+      CopyMem ((VOID*)(mFvInstance->FvBase + Run->Offset), Data, Run->Length);
+      VarStoreMarkDirty (mFvInstance->FvBase + Run->Offset, Run->Length);
+    }
+    Data += Run->Length;
+  }
+}
+
+
 EFI_STATUS
 VarStoreWrite (
   IN     UINTN Address,
@@ -94,8 +222,10 @@ VarStoreWrite (
   IN     UINT8 *Buffer
   )
 {
-  CopyMem ((VOID*)Address, Buffer, *NumBytes);
-  mFvInstance->Dirty = TRUE;
+  if (CompareMem ((VOID*)Address, Buffer, *NumBytes) != 0) {
+    CopyMem ((VOID*)Address, Buffer, *NumBytes);
+    VarStoreMarkDirty (Address, *NumBytes);
+  }
 
   return EFI_SUCCESS;
 }
@@ -108,7 +238,7 @@ VarStoreErase (
   )
 {
   SetMem ((VOID*)Address, LbaLength, 0xff);
-  mFvInstance->Dirty = TRUE;
+  VarStoreMarkDirty (Address, LbaLength);
 
   return EFI_SUCCESS;
 }
@@ -847,6 +977,18 @@ FvbInitialize (
   mFvInstance->FvLength = (UINTN)Length;
   mFvInstance->Offset = StartOffset;
 
+  mFvInstance->DirtyMap = AllocateRuntimeZeroPool (VAR_STORE_DIRTY_MAP_SIZE (Length));
+  if (mFvInstance->DirtyMap == NULL) {
+    FreePool (mFvInstance);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mFvInstance->JournalOffset = PcdGet32 (PcdNvStorageEventLogBase) - (UINT32)BaseAddress;
+  mFvInstance->JournalLength = FixedPcdGet32 (PcdNvStorageEventLogSize);
+  ASSERT (mFvInstance->JournalLength > VAR_STORE_DIRTY_BLOCK_SIZE);
+  ASSERT (sizeof (VAR_STORE_JOURNAL_HEADER) <= VAR_STORE_DIRTY_BLOCK_SIZE);
+  VarStoreReplayJournal ();
+
   Status = ValidateFvHeader (mFvInstance->VolumeHeader);
   if (!EFI_ERROR (Status)) {
     if (mFvInstance->VolumeHeader->FvLength != Length ||
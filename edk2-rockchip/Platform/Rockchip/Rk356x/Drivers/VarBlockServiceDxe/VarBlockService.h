@@ -25,6 +25,44 @@
 #include <Protocol/LoadedImage.h>
 #include <Library/SocLib.h>
 
+//
+// The variable store is flushed in units of this many bytes, and only the
+// units modified since the last flush are written back.
+//
+#define VAR_STORE_DIRTY_BLOCK_SIZE    512
+
+//
+// Clean gaps of up to this many blocks between two dirty runs are written
+// anyway, since one larger write is cheaper than two media commands.
+//
+#define VAR_STORE_DIRTY_MERGE_GAP     8
+
+#define VAR_STORE_DIRTY_MAP_SIZE(Length) \
+          (((Length) / VAR_STORE_DIRTY_BLOCK_SIZE + 7) / 8)
+
+//
+// Flush journal. It lives in the NV event log region, which is otherwise
+// unused. Before the dirty runs are written back, their new contents are
+// written here. If the flush is interrupted, the journal is replayed into
+// the in-memory store on the next boot. The header takes the first block
+// of the region, and the run data follows it.
+//
+#define VAR_STORE_JOURNAL_SIGNATURE   SIGNATURE_32 ('V', 'J', 'N', 'L')
+#define VAR_STORE_JOURNAL_MAX_RUNS    32
+
+typedef struct {
+  UINT32                     Offset;
+  UINT32                     Length;
+} VAR_STORE_JOURNAL_RUN;
+
+typedef struct {
+  UINT32                     Signature;
+  UINT32                     Crc32;
+  UINT32                     Sequence;
+  UINT32                     NumRuns;
+  VAR_STORE_JOURNAL_RUN      Runs[VAR_STORE_JOURNAL_MAX_RUNS];
+} VAR_STORE_JOURNAL_HEADER;
+
 typedef struct {
   union {
     UINTN                      FvBase;
@@ -36,6 +74,13 @@ typedef struct {
   EFI_DEVICE_PATH_PROTOCOL   *Device;
   UINT32                     MediaId;
   BOOLEAN                    Dirty;
+  UINT8                      *DirtyMap;
+  UINTN                      JournalOffset;
+  UINTN                      JournalLength;
+  UINT32                     JournalSequence;
+  BOOLEAN                    JournalStale;
+  UINT32                     FlushCount;
+  UINT64                     FlushBytes;
 } EFI_FW_VOL_INSTANCE;
 
 extern EFI_FW_VOL_INSTANCE *mFvInstance;
@@ -55,6 +100,22 @@ typedef struct {
   EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  FwVolBlockInstance;
 } EFI_FW_VOL_BLOCK_DEVICE;
 
+VOID
+VarStoreMarkDirty (
+  IN UINTN Address,
+  IN UINTN Length
+  );
+
+BOOLEAN
+VarStoreIsBlockDirty (
+  IN UINTN Block
+  );
+
+UINT32
+VarStoreJournalCrc (
+  IN VAR_STORE_JOURNAL_HEADER *Journal
+  );
+
 EFI_STATUS
 GetFvbInfo (
   IN  UINT64                            FvLength,
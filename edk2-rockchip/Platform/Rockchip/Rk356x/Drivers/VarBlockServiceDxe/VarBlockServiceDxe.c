@@ -30,6 +30,7 @@ typedef struct {
 #define PLATFORM_RESET_DELAY    3500000
 
 VOID *mDiskIoRegistration;
+STATIC VOID *mJournalBuffer;
 
 
 VOID
@@ -114,6 +115,7 @@ FvbVirtualAddressChangeEvent (
   EfiConvertPointer (0x0, (VOID**)&mFvInstance->FvBase);
   EfiConvertPointer (0x0, (VOID**)&mFvInstance->VolumeHeader);
   EfiConvertPointer (0x0, (VOID**)&mFvInstance->Device);
+  EfiConvertPointer (0x0, (VOID**)&mFvInstance->DirtyMap);
   EfiConvertPointer (0x0, (VOID**)&mFvInstance);
 }
 
@@ -138,6 +140,68 @@ InstallVirtualAddressChangeHandler (
 }
 
 
+STATIC
+BOOLEAN
+NextDirtyRun (
+  IN OUT UINTN *Block,
+  OUT    UINTN *Start,
+  OUT    UINTN *End
+  )
+{
+  UINTN NumBlocks;
+
+  //
+  // Find the next run of dirty blocks. Runs separated by short clean
+  // gaps are merged into one, since one larger write is cheaper.
+  //
+  NumBlocks = mFvInstance->FvLength / VAR_STORE_DIRTY_BLOCK_SIZE;
+  while (*Block < NumBlocks && !VarStoreIsBlockDirty (*Block)) {
+    (*Block)++;
+  }
+  if (*Block >= NumBlocks) {
+    return FALSE;
+  }
+
+  *Start = *Block;
+  *End = *Block + 1;
+  for (*Block = *End; *Block < NumBlocks && *Block < *End + VAR_STORE_DIRTY_MERGE_GAP; (*Block)++) {
+    if (VarStoreIsBlockDirty (*Block)) {
+      *End = *Block + 1;
+    }
+  }
+  *Block = *End;
+
+  return TRUE;
+}
+
+
+STATIC
+EFI_STATUS
+WriteJournal (
+  IN EFI_DISK_IO_PROTOCOL *DiskIo,
+  IN EFI_BLOCK_IO_PROTOCOL *BlkIo,
+  IN UINT32 MediaId,
+  IN VOID *Buffer,
+  IN UINTN Length
+  )
+{
+  EFI_STATUS Status;
+
+  Status = DiskIo->WriteDisk (
+                      DiskIo,
+                      MediaId,
+                      mFvInstance->Offset + mFvInstance->JournalOffset,
+                      Length,
+                      Buffer
+                    );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return BlkIo->FlushBlocks (BlkIo);
+}
+
+
 STATIC
 EFI_STATUS
 DoDump (
@@ -147,7 +211,16 @@ DoDump (
 {
   EFI_STATUS Status;
   EFI_DISK_IO_PROTOCOL *DiskIo = NULL;
+  EFI_BLOCK_IO_PROTOCOL *BlkIo = NULL;
   EFI_HANDLE Handle;
+  VAR_STORE_JOURNAL_HEADER *Journal;
+  UINT8 *JournalData;
+  UINTN Block;
+  UINTN Start;
+  UINTN End;
+  UINTN Runs;
+  UINTN Bytes;
+  BOOLEAN Journaled;
 
   Status = gBS->LocateDevicePath (
                   &gEfiDiskIoProtocolGuid,
@@ -167,15 +240,130 @@ DoDump (
     return Status;
   }
 
-  Status = DiskIo->WriteDisk (
-                      DiskIo,
-                      MediaId,
-                      mFvInstance->Offset,
-                      mFvInstance->FvLength,
-                      (VOID*)mFvInstance->FvBase
-                    );
+  Status = gBS->HandleProtocol (
+                  Handle,
+                  &gEfiBlockIoProtocolGuid,
+                  (VOID**)&BlkIo
+                );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
 
-  return Status;
+  if (mJournalBuffer == NULL) {
+    Status = gBS->AllocatePool (
+                    EfiBootServicesData,
+                    mFvInstance->JournalLength,
+                    &mJournalBuffer
+                  );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+  Journal = mJournalBuffer;
+  JournalData = (UINT8*)mJournalBuffer + VAR_STORE_DIRTY_BLOCK_SIZE;
+
+  //
+  // Collect the dirty runs and their new contents into the journal.
+  //
+  ZeroMem (Journal, VAR_STORE_DIRTY_BLOCK_SIZE);
+  Journaled = TRUE;
+  Runs = 0;
+  Bytes = 0;
+  Block = 0;
+  while (NextDirtyRun (&Block, &Start, &End)) {
+    if (Runs >= VAR_STORE_JOURNAL_MAX_RUNS ||
+        VAR_STORE_DIRTY_BLOCK_SIZE + Bytes + (End - Start) * VAR_STORE_DIRTY_BLOCK_SIZE > mFvInstance->JournalLength) {
+      Journaled = FALSE;
+    } else {
+      Journal->Runs[Runs].Offset = (UINT32)(Start * VAR_STORE_DIRTY_BLOCK_SIZE);
+      Journal->Runs[Runs].Length = (UINT32)((End - Start) * VAR_STORE_DIRTY_BLOCK_SIZE);
+      CopyMem (JournalData + Bytes,
+        (VOID*)(mFvInstance->FvBase + Journal->Runs[Runs].Offset),
+        Journal->Runs[Runs].Length);
+    }
+    Runs++;
+    Bytes += (End - Start) * VAR_STORE_DIRTY_BLOCK_SIZE;
+  }
+
+  if (Runs == 0) {
+    Journaled = FALSE;
+  } else if (Journaled) {
+    Journal->Signature = VAR_STORE_JOURNAL_SIGNATURE;
+    Journal->Sequence = ++mFvInstance->JournalSequence;
+    Journal->NumRuns = (UINT32)Runs;
+    Journal->Crc32 = VarStoreJournalCrc (Journal);
+
+    Status = WriteJournal (DiskIo, BlkIo, MediaId, Journal, VAR_STORE_DIRTY_BLOCK_SIZE + Bytes);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    mFvInstance->FlushBytes += VAR_STORE_DIRTY_BLOCK_SIZE + Bytes;
+  } else {
+    DEBUG ((DEBUG_WARN, "Variables: %lu bytes in %lu run(s) do not fit the journal, flushing unprotected\n",
+      (UINT64)Bytes, (UINT64)Runs));
+  }
+
+  //
+  // A journal left over from an interrupted flush would be replayed over
+  // unprotected writes after a power loss, so invalidate it before them.
+  // A new journal has already replaced it.
+  //
+  if (!Journaled && mFvInstance->JournalStale) {
+    ZeroMem (Journal, VAR_STORE_DIRTY_BLOCK_SIZE);
+    Status = WriteJournal (DiskIo, BlkIo, MediaId, Journal, VAR_STORE_DIRTY_BLOCK_SIZE);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    mFvInstance->FlushBytes += VAR_STORE_DIRTY_BLOCK_SIZE;
+    mFvInstance->JournalStale = FALSE;
+  }
+
+  //
+  // Write back the runs themselves.
+  //
+  Block = 0;
+  while (NextDirtyRun (&Block, &Start, &End)) {
+    Status = DiskIo->WriteDisk (
+                        DiskIo,
+                        MediaId,
+                        mFvInstance->Offset + Start * VAR_STORE_DIRTY_BLOCK_SIZE,
+                        (End - Start) * VAR_STORE_DIRTY_BLOCK_SIZE,
+                        (VOID*)(mFvInstance->FvBase + Start * VAR_STORE_DIRTY_BLOCK_SIZE)
+                      );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+  mFvInstance->FlushBytes += Bytes;
+
+  //
+  // Once the runs are on the media, invalidate the journal so it is not
+  // replayed.
+  //
+  if (Journaled) {
+    Status = BlkIo->FlushBlocks (BlkIo);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    ZeroMem (Journal, VAR_STORE_DIRTY_BLOCK_SIZE);
+    Status = WriteJournal (DiskIo, BlkIo, MediaId, Journal, VAR_STORE_DIRTY_BLOCK_SIZE);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    mFvInstance->FlushBytes += VAR_STORE_DIRTY_BLOCK_SIZE;
+    mFvInstance->JournalStale = FALSE;
+  }
+
+  mFvInstance->FlushCount++;
+  DEBUG ((DEBUG_INFO, "Variables: flush %u wrote %lu bytes in %lu run(s)%a, %lu bytes total\n",
+    mFvInstance->FlushCount, (UINT64)Bytes, (UINT64)Runs,
+    Journaled ? " (journaled)" : "", mFvInstance->FlushBytes));
+
+  SetMem (mFvInstance->DirtyMap, VAR_STORE_DIRTY_MAP_SIZE (mFvInstance->FvLength), 0);
+  mFvInstance->Dirty = FALSE;
+
+  return EFI_SUCCESS;
 }
 
 
@@ -195,7 +383,7 @@ DumpVars (
     return;
   }
 
-  if (!mFvInstance->Dirty) {
+  if (!mFvInstance->Dirty && !mFvInstance->JournalStale) {
     DEBUG ((DEBUG_INFO, "Variables not dirty, not dumping!\n"));
     return;
   }
@@ -222,8 +410,6 @@ DumpVars (
     PcdStatus = PcdSet32S (PcdPlatformResetDelay, PLATFORM_RESET_DELAY);
     ASSERT_RETURN_ERROR (PcdStatus);
   }
-
-  mFvInstance->Dirty = FALSE;
 }
 
 
@@ -326,6 +512,40 @@ IsBootDevice (
   return FALSE;
 }
 
+/**
+  Find where the variable store lives on the boot device.
+
+  FvbInitialize() computes the offset used by the SD/eMMC layout, where the
+  FIT image sits 10 MiB into the card.
+
+  @param[in]  BlkIo         Block I/O protocol of the boot device.
+  @param[out] Offset        Byte offset of the store on the device.
+
+  @retval TRUE              The store fits on the device.
+  @retval FALSE             The device cannot hold the store.
+
+**/
+STATIC
+BOOLEAN
+GetStoreOffset (
+  IN  EFI_BLOCK_IO_PROTOCOL *BlkIo,
+  OUT UINT64 *Offset
+  )
+{
+  UINT64 MediaSize;
+
+  *Offset = mFvInstance->Offset;
+
+  MediaSize = MultU64x32 (BlkIo->Media->LastBlock + 1, BlkIo->Media->BlockSize);
+  if (*Offset + mFvInstance->FvLength > MediaSize) {
+    DEBUG ((DEBUG_ERROR, "VarBlockService: Store at 0x%lx-0x%lx does not fit on 0x%lx byte device\n",
+            *Offset, *Offset + mFvInstance->FvLength, MediaSize));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 VOID
 EFIAPI
 OnDiskIoInstall (
@@ -339,6 +559,7 @@ OnDiskIoInstall (
   EFI_DEVICE_PATH_PROTOCOL *Device;
   EFI_BLOCK_IO_PROTOCOL *BlkIo;
   CHAR16 *DevicePathText = NULL;
+  UINT64 Offset;
 
   if (mFvInstance->Device != NULL) {
     //
@@ -392,14 +613,15 @@ OnDiskIoInstall (
       DEBUG ((DEBUG_ERROR, "VarBlockService: [%s] Media is read-only!\n", DevicePathText));
       continue;
     }
-
-    Status = DoDump (Device, BlkIo->Media->MediaId);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "VarBlockService: [%s] Couldn't update %a\n", DevicePathText));
-      ASSERT_EFI_ERROR (Status);
+    if (!GetStoreOffset (BlkIo, &Offset)) {
       continue;
     }
 
+    //
+    // Nothing is written here. Dirty state is coalesced and flushed once
+    // per boot phase: at ReadyToBoot, when an image is loaded after that,
+    // and on reset.
+    //
     if (mFvInstance->Device != NULL) {
       gBS->FreePool (mFvInstance->Device);
     }
@@ -407,6 +629,7 @@ OnDiskIoInstall (
     DEBUG ((DEBUG_INFO, "VarBlockService: [%s] Found variable store!\n", DevicePathText));
     mFvInstance->Device = Device;
     mFvInstance->MediaId = BlkIo->Media->MediaId;
+    mFvInstance->Offset = (UINTN)Offset;
     break;
   }
 
@@ -11,6 +11,8 @@
 #ifndef CONFIG_VARS_H
 #define CONFIG_VARS_H
 
+#include <Rk356xConfigValues.h>
+
 typedef struct {
 #define SYSTEM_TABLE_MODE_ACPI 0
 #define SYSTEM_TABLE_MODE_BOTH 1
@@ -41,4 +43,29 @@ typedef struct {
   BOOLEAN Mode;
 } FAN_VARSTORE_DATA;
 
+typedef struct {
+  /* EMMC_BUS_MODE_* in Rk356xConfigValues.h */
+  UINT32 Mode;
+} EMMC_BUS_MODE_VARSTORE_DATA;
+
+typedef struct {
+  UINT32 Clock;
+} EMMC_CLOCK_VARSTORE_DATA;
+
+typedef struct {
+  /* EMMC_STATUS_MODE_* in Rk356xConfigValues.h */
+  UINT32 Mode;
+  UINT32 Clock;
+} EMMC_STATUS_VARSTORE_DATA;
+
+typedef struct {
+  /* DISPLAY_POWER_* in Rk356xConfigValues.h */
+  UINT32 Policy;
+} DISPLAY_POWER_VARSTORE_DATA;
+
+typedef struct {
+  /* DISPLAY_COLOR_DEPTH_* in Rk356xConfigValues.h */
+  UINT32 Depth;
+} DISPLAY_COLOR_DEPTH_VARSTORE_DATA;
+
 #endif /* CONFIG_VARS_H */
\ No newline at end of file
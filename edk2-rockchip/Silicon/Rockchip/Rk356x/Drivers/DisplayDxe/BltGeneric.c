@@ -0,0 +1,156 @@
+/** @file
+ *
+ *  Portable pixel row kernels for DisplayBlt.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#include <Base.h>
+
+#include "BltSupport.h"
+
+VOID
+EFIAPI
+DisplayBltFillGeneric (
+  OUT VOID    *Dst,
+  IN  UINT32  Pixel,
+  IN  UINTN   Count
+  )
+{
+  UINT32 *D = Dst;
+
+  while (Count-- > 0) {
+    *D++ = Pixel;
+  }
+}
+
+VOID
+EFIAPI
+DisplayBltCopyGeneric (
+  OUT VOID        *Dst,
+  IN  CONST VOID  *Src,
+  IN  UINTN       Count
+  )
+{
+  UINT32 *D = Dst;
+  CONST UINT32 *S = Src;
+
+  if (D > S && D < S + Count) {
+    /* Destination overlaps the tail of the source, copy backwards */
+    D += Count;
+    S += Count;
+    while (Count-- > 0) {
+      *--D = *--S;
+    }
+  } else {
+    while (Count-- > 0) {
+      *D++ = *S++;
+    }
+  }
+}
+
+VOID
+EFIAPI
+DisplayBltFill16 (
+  OUT VOID    *Dst,
+  IN  UINT16  Pixel,
+  IN  UINTN   Count
+  )
+{
+  UINT16 *D = Dst;
+
+  if ((Count & 1) != 0) {
+    D[Count - 1] = Pixel;
+  }
+  DisplayBltFill (D, Pixel | ((UINT32)Pixel << 16), Count / 2);
+}
+
+VOID
+EFIAPI
+DisplayBltCopy16 (
+  OUT VOID        *Dst,
+  IN  CONST VOID  *Src,
+  IN  UINTN       Count
+  )
+{
+  UINT16 *D = Dst;
+  CONST UINT16 *S = Src;
+
+  if ((Count & 1) == 0) {
+    DisplayBltCopy (D, S, Count / 2);
+  } else if (D > S) {
+    /* Backwards overlap: the odd pixel at the end has to go first */
+    D[Count - 1] = S[Count - 1];
+    DisplayBltCopy (D, S, Count / 2);
+  } else {
+    DisplayBltCopy (D, S, Count / 2);
+    D[Count - 1] = S[Count - 1];
+  }
+}
+
+VOID
+EFIAPI
+DisplayBltToRgb565 (
+  OUT VOID        *Dst,
+  IN  CONST VOID  *Src,
+  IN  UINTN       Count
+  )
+{
+  UINT16 *D = Dst;
+  CONST UINT32 *S = Src;
+
+  while (Count-- > 0) {
+    *D++ = DISPLAY_PIXEL_TO_RGB565 (*S);
+    S++;
+  }
+}
+
+VOID
+EFIAPI
+DisplayBltFromRgb565 (
+  OUT VOID        *Dst,
+  IN  CONST VOID  *Src,
+  IN  UINTN       Count
+  )
+{
+  UINT32 *D = Dst;
+  CONST UINT16 *S = Src;
+  UINT32 R, G, B;
+
+  while (Count-- > 0) {
+    R = (*S >> 11) & 0x1F;
+    G = (*S >> 5) & 0x3F;
+    B = *S & 0x1F;
+    *D++ = (((R << 3) | (R >> 2)) << 16) |
+           (((G << 2) | (G >> 4)) << 8) |
+           ((B << 3) | (B >> 2));
+    S++;
+  }
+}
+
+#if !defined (MDE_CPU_AARCH64)
+VOID
+EFIAPI
+DisplayBltFill (
+  OUT VOID    *Dst,
+  IN  UINT32  Pixel,
+  IN  UINTN   Count
+  )
+{
+  DisplayBltFillGeneric (Dst, Pixel, Count);
+}
+
+VOID
+EFIAPI
+DisplayBltCopy (
+  OUT VOID        *Dst,
+  IN  CONST VOID  *Src,
+  IN  UINTN       Count
+  )
+{
+  DisplayBltCopyGeneric (Dst, Src, Count);
+}
+#endif
@@ -0,0 +1,108 @@
+/** @file
+ *
+ *  Pixel row kernels used by DisplayBlt.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#ifndef _BLT_SUPPORT_H_
+#define _BLT_SUPPORT_H_
+
+/**
+  Store Pixel to Count consecutive 32-bit pixels at Dst.
+
+**/
+VOID
+EFIAPI
+DisplayBltFill (
+  OUT VOID    *Dst,
+  IN  UINT32  Pixel,
+  IN  UINTN   Count
+  );
+
+/**
+  Copy Count 32-bit pixels from Src to Dst. The buffers may overlap.
+
+**/
+VOID
+EFIAPI
+DisplayBltCopy (
+  OUT VOID        *Dst,
+  IN  CONST VOID  *Src,
+  IN  UINTN       Count
+  );
+
+/*
+ * 16 bpp (RGB565) variants. Fill and copy run on the 32-bit kernels above
+ * two pixels at a time; the format conversions are plain C.
+ */
+VOID
+EFIAPI
+DisplayBltFill16 (
+  OUT VOID    *Dst,
+  IN  UINT16  Pixel,
+  IN  UINTN   Count
+  );
+
+VOID
+EFIAPI
+DisplayBltCopy16 (
+  OUT VOID        *Dst,
+  IN  CONST VOID  *Src,
+  IN  UINTN       Count
+  );
+
+/**
+  Convert Count BGRA8888 pixels at Src to RGB565 at Dst.
+
+**/
+VOID
+EFIAPI
+DisplayBltToRgb565 (
+  OUT VOID        *Dst,
+  IN  CONST VOID  *Src,
+  IN  UINTN       Count
+  );
+
+/**
+  Convert Count RGB565 pixels at Src to BGRA8888 at Dst, replicating the
+  top bits of each channel into the bottom ones.
+
+**/
+VOID
+EFIAPI
+DisplayBltFromRgb565 (
+  OUT VOID        *Dst,
+  IN  CONST VOID  *Src,
+  IN  UINTN       Count
+  );
+
+#define DISPLAY_PIXEL_TO_RGB565(Pixel)            \
+  ((UINT16)((((Pixel) >> 8) & 0xF800) |           \
+            (((Pixel) >> 5) & 0x07E0) |           \
+            (((Pixel) >> 3) & 0x001F)))
+
+/*
+ * Plain C versions of DisplayBltFill and DisplayBltCopy. The AArch64 build uses NEON instead;
+ * these are kept as the reference the assembly has to match.
+ */
+VOID
+EFIAPI
+DisplayBltFillGeneric (
+  OUT VOID    *Dst,
+  IN  UINT32  Pixel,
+  IN  UINTN   Count
+  );
+
+VOID
+EFIAPI
+DisplayBltCopyGeneric (
+  OUT VOID        *Dst,
+  IN  CONST VOID  *Src,
+  IN  UINTN       Count
+  );
+
+#endif /* _BLT_SUPPORT_H_ */
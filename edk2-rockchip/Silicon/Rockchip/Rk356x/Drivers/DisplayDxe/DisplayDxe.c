@@ -11,18 +11,91 @@
 
 #include <Base.h>
 #include "DisplayDxe.h"
+#include "BltSupport.h"
 #include "DwHdmi.h"
 #include "Vop2.h"
 #include <Library/CruLib.h>
+#include <Library/PmuProfileLib.h>
+#include <Library/SocLib.h>
+#include <Library/UefiBootManagerLib.h>
+#include <Rk356xConfigValues.h>
 
 #define POS_TO_FB(posX, posY) ((UINT8*)                                 \
                                ((UINTN)This->Mode->FrameBufferBase +    \
-                                (posY) * This->Mode->Info->PixelsPerScanLine * \
-                                RK_BYTES_PER_PIXEL +                    \
-                                (posX) * RK_BYTES_PER_PIXEL))
+                                ((posY) + mScrollOffset) *              \
+                                This->Mode->Info->PixelsPerScanLine *   \
+                                mBytesPerPixel +                        \
+                                (posX) * mBytesPerPixel))
+
+#define POS_TO_SHADOW(posX, posY) (mShadowFb +                         \
+                                   ((posY) + mScrollOffset) *           \
+                                   This->Mode->Info->PixelsPerScanLine * \
+                                   mBytesPerPixel +                     \
+                                   (posX) * mBytesPerPixel)
+
+/*
+ * Hardware scrolling. Both the scanout buffer and the shadow have
+ * DISPLAY_SCROLL_RATIO times as many rows as the mode, and the visible
+ * screen starts mScrollOffset rows in. A full-width VideoToVideo that moves
+ * content up just advances the offset and points the ESMART layer at the
+ * new start, copying only the rows outside the moved rectangle. Once the
+ * spare rows run out the screen is copied back to the top.
+ *
+ * FrameBufferBase always points at row 0, so hardware scrolling is only
+ * used by the firmware's own console. At ReadyToBoot, before any boot
+ * option can draw straight into the framebuffer, scanout is moved back to
+ * row 0 and scrolling falls back to copying.
+ */
+#define DISPLAY_SCROLL_RATIO            2
+
+/* Delay before checking a cached EDID against the attached monitor */
+#define DISPLAY_EDID_VERIFY_DELAY       (100 * 10000)   /* 100 ms in 100 ns units */
+
+/*
+ * DriverStart only arms a timer; the controller is brought up one step per
+ * tick so the rest of BDS keeps running while the PHY powers up and the
+ * EDID is read. No step waits on more than one thing: an EDID block, the
+ * HPLL or the PHY. Without a monitor plugged in, bring-up stops after the
+ * hot plug check.
+ */
+#define DISPLAY_START_PERIOD            (1 * 10000)     /* 1 ms in 100 ns units */
+
+typedef enum {
+  DisplayStateStopped,
+  DisplayStateInit,
+  DisplayStateDetect,
+  DisplayStateEdid,
+  DisplayStateEdidRead,
+  DisplayStateBuffers,
+  DisplayStateScanout,
+  DisplayStateLink,
+  DisplayStateInstall,
+  DisplayStateRunning
+} DISPLAY_START_STATE;
+
+/*
+ * Blt operations work on a write-back shadow copy of the framebuffer, so
+ * reads (console scrolling in particular) never touch write-combined
+ * memory. Updated areas are queued as dirty rectangles and copied to the
+ * scanout buffer by a periodic timer, at ExitBootServices, or when the
+ * queue fills up. Clients that write FrameBufferBase directly and then read
+ * it back through Blt will see the shadow, not their own writes.
+ */
+#define DISPLAY_MAX_DIRTY_RECTS         16
+#define DISPLAY_FLUSH_PERIOD            (20 * 10000)    /* 20 ms in 100 ns units */
+
+typedef struct {
+  UINTN X;
+  UINTN Y;
+  UINTN Width;
+  UINTN Height;
+} DISPLAY_RECT;
 
 HDMI_DISPLAY_TIMING mPreferredTimings;
 
+/* Timing found during bring-up, applied together with the new mode list */
+STATIC HDMI_DISPLAY_TIMING mStartTimings;
+
 /* Fallback to 720p when DDC fails */
 STATIC HDMI_DISPLAY_TIMING mDefaultTimings = {
     .Vic = 4,
@@ -60,6 +133,14 @@ DriverStop (
   IN EFI_HANDLE                  *ChildHandleBuffer
   );
 
+STATIC
+VOID
+EFIAPI
+DisplayStartStep (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  );
+
 STATIC
 EFI_STATUS
 EFIAPI
@@ -108,18 +189,65 @@ typedef struct {
   EFI_DEVICE_PATH EndDevicePath;
 } DISPLAY_DEVICE_PATH;
 
-typedef struct {
-  UINT32 Width;
-  UINT32 Height;
-} GOP_MODE_DATA;
-
 STATIC EFI_HANDLE mDevice;
 STATIC EFI_CPU_ARCH_PROTOCOL *mCpu;
 STATIC EFI_PHYSICAL_ADDRESS mFbBase;
 STATIC UINTN mFbNumPages;
+STATIC UINTN mFbRuntimePages;
+STATIC UINT8 *mShadowFb;
+STATIC UINTN mShadowFbNumPages;
+STATIC DISPLAY_RECT mDirtyRects[DISPLAY_MAX_DIRTY_RECTS];
+STATIC UINTN mNumDirtyRects;
+STATIC EFI_EVENT mFlushEvent;
+STATIC EFI_EVENT mExitBootServicesEvent;
+STATIC EFI_EVENT mReadyToBootEvent;
+STATIC EFI_EVENT mEdidVerifyEvent;
+STATIC BOOLEAN mHdmiEnabled;
+STATIC UINTN mScrollOffset;
+STATIC UINTN mScrollRows;
+STATIC BOOLEAN mHwScrollEnabled = TRUE;
+STATIC EFI_EVENT mStartEvent;
+STATIC DISPLAY_START_STATE mStartState;
+STATIC BOOLEAN mGopInstalled;
+STATIC EFI_HANDLE mStartController;
+STATIC EFI_HANDLE mStartDriverBindingHandle;
+STATIC BOOLEAN mDisplayPoweredOff;
+STATIC UINTN mBytesPerPixel = 4;
+
+/*
+ * VOP and HDMI clocks, gated while the VO domain is off. Listed children
+ * first, so they are gated in order and ungated in reverse.
+ */
+STATIC CONST struct {
+  UINT32  Con;
+  UINT8   Bit;
+} mDisplayClockGates[] = {
+  { 21, 3 },    /* pclk_hdmi_host */
+  { 21, 4 },    /* clk_hdmi_sfr */
+  { 20, 8 },    /* aclk_vop */
+  { 20, 9 },    /* hclk_vop */
+  { 20, 10 },   /* dclk_vop0 */
+  { 20, 11 },   /* dclk_vop1 */
+  { 20, 12 },   /* dclk_vop2 */
+  { 20, 6 },    /* aclk_vop_pre */
+};
 
-STATIC GOP_MODE_DATA mGopModeData[] = {
-  { 0, 0 }
+/*
+ * Mode 0 is the monitor's preferred timing. Every other mode uses the same
+ * monitor timing with a smaller framebuffer that the ESMART layer scales up,
+ * so switching modes never retrains the link and a 4K monitor can run the
+ * console from a 1080p or 720p framebuffer.
+ */
+#define DISPLAY_MAX_MODES               16
+#define DISPLAY_MIN_WIDTH               640
+#define DISPLAY_MIN_HEIGHT              480
+
+STATIC GOP_MODE_DATA mGopModeData[DISPLAY_MAX_MODES];
+
+/* Always offered when they fit, even if the EDID doesn't list them */
+STATIC CONST GOP_MODE_DATA mExtraModes[] = {
+  { 1920, 1080 },
+  { 1280, 720 },
 };
 
 STATIC DISPLAY_DEVICE_PATH mDisplayProtoDevicePath =
@@ -145,9 +273,6 @@ STATIC DISPLAY_DEVICE_PATH mDisplayProtoDevicePath =
   }
 };
 
-#define RK_BITS_PER_PIXEL               (32)
-#define RK_BYTES_PER_PIXEL              (RK_BITS_PER_PIXEL / 8)
-
 EFI_GRAPHICS_OUTPUT_PROTOCOL gDisplayProto = {
   DisplayQueryMode,
   DisplaySetMode,
@@ -155,6 +280,21 @@ EFI_GRAPHICS_OUTPUT_PROTOCOL gDisplayProto = {
   NULL
 };
 
+/**
+  Return the framebuffer stride for a mode Width pixels wide. The VOP
+  takes the stride in 32-bit words, so 16 bpp rows are padded to an even
+  number of pixels.
+
+**/
+STATIC
+UINT32
+DisplayPixelsPerScanLine (
+  IN UINT32 Width
+  )
+{
+  return mBytesPerPixel == 2 ? ALIGN_VALUE (Width, 2) : Width;
+}
+
 STATIC
 EFI_STATUS
 EFIAPI
@@ -192,11 +332,578 @@ DisplayQueryMode (
   (*Info)->PixelInformation.GreenMask = This->Mode->Info->PixelInformation.GreenMask;
   (*Info)->PixelInformation.BlueMask = This->Mode->Info->PixelInformation.BlueMask;
   (*Info)->PixelInformation.ReservedMask = This->Mode->Info->PixelInformation.ReservedMask;
-  (*Info)->PixelsPerScanLine = Mode->Width;
+  (*Info)->PixelsPerScanLine = DisplayPixelsPerScanLine (Mode->Width);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Copy Count pixels in the framebuffer format. The buffers may overlap.
+
+**/
+STATIC
+VOID
+DisplayCopyPixels (
+  OUT VOID        *Dst,
+  IN  CONST VOID  *Src,
+  IN  UINTN       Count
+  )
+{
+  if (mBytesPerPixel == 2) {
+    DisplayBltCopy16 (Dst, Src, Count);
+  } else {
+    DisplayBltCopy (Dst, Src, Count);
+  }
+}
+
+/**
+  Copy one dirty rectangle from the shadow to the scanout buffer.
+
+**/
+STATIC
+VOID
+DisplayFlushRect (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL *This,
+  IN DISPLAY_RECT                 *Rect
+  )
+{
+  UINTN i;
+
+  if (Rect->X == 0 && Rect->Width == This->Mode->Info->PixelsPerScanLine) {
+    /* Full rows are contiguous, so move them in one go */
+    DisplayCopyPixels (POS_TO_FB (0, Rect->Y), POS_TO_SHADOW (0, Rect->Y),
+      Rect->Height * This->Mode->Info->PixelsPerScanLine);
+    return;
+  }
+
+  for (i = 0; i < Rect->Height; i++) {
+    DisplayCopyPixels (POS_TO_FB (Rect->X, Rect->Y + i),
+      POS_TO_SHADOW (Rect->X, Rect->Y + i),
+      Rect->Width);
+  }
+}
+
+/**
+  Copy all pending dirty rectangles to the scanout buffer. Must be called
+  at TPL_NOTIFY or with the TPL raised to it.
+
+**/
+STATIC
+VOID
+DisplayFlush (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL *This
+  )
+{
+  UINTN Index;
+
+  for (Index = 0; Index < mNumDirtyRects; Index++) {
+    DisplayFlushRect (This, &mDirtyRects[Index]);
+  }
+  mNumDirtyRects = 0;
+}
+
+/**
+  Queue an updated area for flushing.
+
+  Rectangles are only merged when their union is exactly the two areas
+  combined: same columns and touching rows, same rows and touching columns,
+  or one inside the other. This never copies pixels that Blt did not write,
+  and it still folds a console line drawn glyph by glyph into a single
+  rectangle.
+
+**/
+STATIC
+VOID
+DisplayMarkDirty (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL *This,
+  IN UINTN                        X,
+  IN UINTN                        Y,
+  IN UINTN                        Width,
+  IN UINTN                        Height
+  )
+{
+  DISPLAY_RECT *Rect;
+  UINTN Index;
+
+  for (Index = 0; Index < mNumDirtyRects; Index++) {
+    Rect = &mDirtyRects[Index];
+
+    if (X >= Rect->X && X + Width <= Rect->X + Rect->Width &&
+        Y >= Rect->Y && Y + Height <= Rect->Y + Rect->Height) {
+      return;
+    }
+    if (Rect->X >= X && Rect->X + Rect->Width <= X + Width &&
+        Rect->Y >= Y && Rect->Y + Rect->Height <= Y + Height) {
+      Rect->X = X;
+      Rect->Y = Y;
+      Rect->Width = Width;
+      Rect->Height = Height;
+      return;
+    }
+    if (X == Rect->X && Width == Rect->Width &&
+        Y <= Rect->Y + Rect->Height && Rect->Y <= Y + Height) {
+      Height = MAX (Y + Height, Rect->Y + Rect->Height) - MIN (Y, Rect->Y);
+      Rect->Y = MIN (Y, Rect->Y);
+      Rect->Height = Height;
+      return;
+    }
+    if (Y == Rect->Y && Height == Rect->Height &&
+        X <= Rect->X + Rect->Width && Rect->X <= X + Width) {
+      Width = MAX (X + Width, Rect->X + Rect->Width) - MIN (X, Rect->X);
+      Rect->X = MIN (X, Rect->X);
+      Rect->Width = Width;
+      return;
+    }
+  }
+
+  if (mNumDirtyRects == DISPLAY_MAX_DIRTY_RECTS) {
+    DisplayFlush (This);
+  }
+
+  Rect = &mDirtyRects[mNumDirtyRects++];
+  Rect->X = X;
+  Rect->Y = Y;
+  Rect->Width = Width;
+  Rect->Height = Height;
+}
+
+/**
+  Copy Count rows starting at row From of the shadow to row To, both
+  physical rows, allowing the ranges to overlap.
+
+**/
+STATIC
+VOID
+DisplayShadowMoveRows (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL *This,
+  IN UINTN                        To,
+  IN UINTN                        From,
+  IN UINTN                        Count
+  )
+{
+  UINTN Stride;
+
+  if (Count == 0 || To == From) {
+    return;
+  }
+
+  Stride = This->Mode->Info->PixelsPerScanLine * mBytesPerPixel;
+  DisplayCopyPixels (mShadowFb + To * Stride, mShadowFb + From * Stride,
+    Count * This->Mode->Info->PixelsPerScanLine);
+}
+
+/**
+  Copy Count physical rows starting at Row from the shadow to the scanout
+  buffer.
+
+**/
+STATIC
+VOID
+DisplayShadowToFbRows (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL *This,
+  IN UINTN                        Row,
+  IN UINTN                        Count
+  )
+{
+  UINTN Stride;
+
+  if (Count == 0) {
+    return;
+  }
+
+  Stride = This->Mode->Info->PixelsPerScanLine * mBytesPerPixel;
+  DisplayCopyPixels ((UINT8 *)(UINTN)This->Mode->FrameBufferBase + Row * Stride,
+    mShadowFb + Row * Stride, Count * This->Mode->Info->PixelsPerScanLine);
+}
+
+STATIC
+VOID
+DisplaySetScanout (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL *This
+  )
+{
+  Vop2SetScanout (This->Mode->FrameBufferBase + mScrollOffset *
+    This->Mode->Info->PixelsPerScanLine * mBytesPerPixel);
+}
+
+/**
+  Move rows [SrcY, SrcY + Height) of the screen up to DestY by moving the
+  scanout start instead of the pixels. Must be called at TPL_NOTIFY.
+
+**/
+STATIC
+VOID
+DisplayHwScroll (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL *This,
+  IN UINTN                        SrcY,
+  IN UINTN                        DestY,
+  IN UINTN                        Height
+  )
+{
+  UINTN VRes;
+  UINTN Delta;
+  UINTN OldOffset;
+  UINTN NewOffset;
+  UINTN Tail;
+
+  VRes = This->Mode->Info->VerticalResolution;
+  Delta = SrcY - DestY;
+  Tail = VRes - DestY - Height;
+  OldOffset = mScrollOffset;
+
+  /* The scanout buffer must match the shadow before rows are reused */
+  DisplayFlush (This);
+
+  if (OldOffset + Delta + VRes <= mScrollRows) {
+    /*
+     * Everything inside the rectangle lands in place by moving the
+     * window; rows above and below it have to move down with it.
+     */
+    NewOffset = OldOffset + Delta;
+    DisplayShadowMoveRows (This, NewOffset + DestY + Height, OldOffset + DestY + Height, Tail);
+    DisplayShadowMoveRows (This, NewOffset, OldOffset, DestY);
+    DisplayShadowToFbRows (This, NewOffset, DestY);
+    DisplayShadowToFbRows (This, NewOffset + DestY + Height, Tail);
+  } else {
+    /*
+     * Out of spare rows: rebuild the screen at the top of the buffer.
+     * Every row moves towards row 0, so ascending order is safe.
+     */
+    NewOffset = 0;
+    DisplayShadowMoveRows (This, 0, OldOffset, DestY);
+    DisplayShadowMoveRows (This, DestY, OldOffset + SrcY, Height);
+    DisplayShadowMoveRows (This, DestY + Height, OldOffset + DestY + Height, Tail);
+    DisplayShadowToFbRows (This, 0, VRes);
+  }
+
+  mScrollOffset = NewOffset;
+  DisplaySetScanout (This);
+}
+
+/**
+  Move the visible screen back to the start of the framebuffer.
+
+**/
+STATIC
+VOID
+DisplayHomeScanout (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL *This
+  )
+{
+  UINTN OldOffset;
+
+  DisplayFlush (This);
+  if (mScrollOffset == 0) {
+    return;
+  }
+
+  OldOffset = mScrollOffset;
+  mScrollOffset = 0;
+  DisplayShadowMoveRows (This, 0, OldOffset, This->Mode->Info->VerticalResolution);
+  DisplayShadowToFbRows (This, 0, This->Mode->Info->VerticalResolution);
+  DisplaySetScanout (This);
+}
+
+STATIC
+VOID
+EFIAPI
+DisplayReadyToBoot (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_TPL OldTpl;
+
+  if (gDisplayProto.Mode == NULL) {
+    return;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  mHwScrollEnabled = FALSE;
+  DisplayHomeScanout (&gDisplayProto);
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Check a cached EDID against the monitor once the display is up. If it has
+  changed, run bring-up again from the EDID read: the new monitor's EDID is
+  read a block per tick and its preferred mode is set, or the default
+  timing if the EDID can't be read. GOP is then reinstalled so its
+  consumers pick up the new mode list.
+
+**/
+STATIC
+VOID
+EFIAPI
+DisplayVerifyEdid (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_STATUS Status;
+
+  gBS->CloseEvent (Event);
+  mEdidVerifyEvent = NULL;
+
+  if (DwHdmiVerifyEdidCache () || mStartState != DisplayStateRunning) {
+    return;
+  }
+
+  DEBUG ((DEBUG_WARN, "Display: Monitor changed, setting its preferred mode\n"));
+  mStartTimings = mDefaultTimings;
+  DwHdmiReadEdidStart ();
+  mStartState = DisplayStateEdidRead;
+
+  Status = gBS->CreateEvent (EVT_TIMER | EVT_NOTIFY_SIGNAL, TPL_CALLBACK,
+                  DisplayStartStep, NULL, &mStartEvent);
+  if (!EFI_ERROR (Status)) {
+    Status = gBS->SetTimer (mStartEvent, TimerPeriodic, DISPLAY_START_PERIOD);
+  }
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Display: Couldn't switch modes: %r\n", Status));
+    if (mStartEvent != NULL) {
+      gBS->CloseEvent (mStartEvent);
+      mStartEvent = NULL;
+    }
+    mStartState = DisplayStateRunning;
+  }
+}
+
+STATIC
+VOID
+EFIAPI
+DisplayFlushTimer (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  if (gDisplayProto.Mode != NULL && mNumDirtyRects != 0) {
+    DisplayFlush (&gDisplayProto);
+  }
+}
+
+/**
+  Stop scanout, power down the HDMI PHY, switch off the VO power domain
+  and gate the VOP and HDMI clocks. Only touches registers, so it is safe
+  to call from ExitBootServices.
+
+**/
+STATIC
+VOID
+DisplayPowerOff (
+  VOID
+  )
+{
+  UINT64 Bandwidth;
+  UINTN Index;
+
+  if (mDisplayPoweredOff) {
+    return;
+  }
+
+  Bandwidth = Vop2Disable ();
+  DwHdmiDisable ();
+  mHdmiEnabled = FALSE;
+
+  if (EFI_ERROR (SocSetPowerDomain (PMU_PD_VO, FALSE))) {
+    /* Leave the clocks running so the domain is still reachable */
+    return;
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mDisplayClockGates); Index++) {
+    CruDisableClock (mDisplayClockGates[Index].Con, mDisplayClockGates[Index].Bit);
+  }
+  mDisplayPoweredOff = TRUE;
+
+  DEBUG ((DEBUG_INFO, "Display: Powered down VOP and HDMI\n"));
+  if (Bandwidth != 0) {
+    DEBUG ((DEBUG_WARN, "Display: Scanout was using %lu MB/s of DDR bandwidth\n",
+            DivU64x32 (Bandwidth, 1000000)));
+  }
+}
+
+/**
+  Undo DisplayPowerOff so the controller can be brought up again.
+
+**/
+STATIC
+VOID
+DisplayPowerOn (
+  VOID
+  )
+{
+  UINTN Index;
+
+  if (!mDisplayPoweredOff) {
+    return;
+  }
+
+  for (Index = ARRAY_SIZE (mDisplayClockGates); Index > 0; Index--) {
+    CruEnableClock (mDisplayClockGates[Index - 1].Con, mDisplayClockGates[Index - 1].Bit);
+  }
+  SocSetPowerDomain (PMU_PD_VO, TRUE);
+  mDisplayPoweredOff = FALSE;
+}
+
+STATIC
+VOID
+EFIAPI
+DisplayExitBootServices (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  if (gDisplayProto.Mode == NULL) {
+    return;
+  }
+
+  /* The OS reprograms the display itself, so don't keep scanning out */
+  if (PcdGet32 (PcdDisplayPowerPolicy) == DISPLAY_POWER_OFF_AT_EBS) {
+    DisplayPowerOff ();
+    return;
+  }
+
+  mHwScrollEnabled = FALSE;
+  DisplayHomeScanout (&gDisplayProto);
+}
+
+/**
+  Fill in mGopModeData from the preferred timing and the EDID, largest
+  framebuffer first.
+
+  @return The number of modes.
+
+**/
+STATIC
+UINT32
+DisplayBuildModeList (
+  VOID
+  )
+{
+  GOP_MODE_DATA EdidModes[DISPLAY_MAX_MODES];
+  GOP_MODE_DATA Mode;
+  UINTN NumEdidModes;
+  UINT32 NumModes;
+  UINTN Index;
+  UINT32 Cur;
+  UINT32 Pos;
+
+  mGopModeData[0].Width = mPreferredTimings.HDisplay;
+  mGopModeData[0].Height = mPreferredTimings.VDisplay;
+  NumModes = 1;
+
+  NumEdidModes = DwHdmiGetEdidModes (EdidModes, ARRAY_SIZE (EdidModes));
+  for (Index = 0; Index < NumEdidModes + ARRAY_SIZE (mExtraModes); Index++) {
+    if (Index < NumEdidModes) {
+      Mode = EdidModes[Index];
+    } else {
+      Mode = mExtraModes[Index - NumEdidModes];
+    }
+
+    /* The scaler only goes up */
+    if (Mode.Width > mGopModeData[0].Width ||
+        Mode.Height > mGopModeData[0].Height ||
+        Mode.Width < DISPLAY_MIN_WIDTH ||
+        Mode.Height < DISPLAY_MIN_HEIGHT) {
+      continue;
+    }
+
+    for (Cur = 0; Cur < NumModes; Cur++) {
+      if (mGopModeData[Cur].Width == Mode.Width &&
+          mGopModeData[Cur].Height == Mode.Height) {
+        break;
+      }
+    }
+    if (Cur < NumModes || NumModes == DISPLAY_MAX_MODES) {
+      continue;
+    }
+
+    /* Insertion sort by area behind the preferred mode */
+    for (Pos = NumModes; Pos > 1; Pos--) {
+      if (mGopModeData[Pos - 1].Width * mGopModeData[Pos - 1].Height >=
+          Mode.Width * Mode.Height) {
+        break;
+      }
+      mGopModeData[Pos] = mGopModeData[Pos - 1];
+    }
+    mGopModeData[Pos] = Mode;
+    NumModes++;
+  }
+
+  for (Cur = 0; Cur < NumModes; Cur++) {
+    DEBUG ((DEBUG_INFO, "Display: Mode %u: %ux%u\n",
+            Cur, mGopModeData[Cur].Width, mGopModeData[Cur].Height));
+  }
+
+  return NumModes;
+}
+
+/**
+  Allocate a framebuffer of NumPages below 4 GiB for scanout. Only the
+  first RuntimePages, which the OS keeps scanning out after
+  ExitBootServices, are runtime memory. The spare rows for hardware
+  scrolling after them are boot services memory and go back to the OS.
+
+**/
+STATIC
+EFI_STATUS
+DisplayAllocateFramebuffer (
+  IN UINTN NumPages,
+  IN UINTN RuntimePages
+  )
+{
+  EFI_PHYSICAL_ADDRESS Base;
+  EFI_STATUS Status;
+  EFI_TPL OldTpl;
+
+  /*
+   * Both parts have to be contiguous, so find room for all of it and then
+   * retype the head. Nothing else can allocate at TPL_NOTIFY in between.
+   */
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Base = SIZE_4GB - 1;
+  Status = gBS->AllocatePages (AllocateMaxAddress, EfiBootServicesData,
+                  NumPages, &Base);
+  if (!EFI_ERROR (Status)) {
+    gBS->FreePages (Base, RuntimePages);
+    Status = gBS->AllocatePages (AllocateAddress, EfiRuntimeServicesData,
+                    RuntimePages, &Base);
+    if (EFI_ERROR (Status) && NumPages > RuntimePages) {
+      gBS->FreePages (Base + EFI_PAGES_TO_SIZE (RuntimePages),
+        NumPages - RuntimePages);
+    }
+  }
+  gBS->RestoreTPL (OldTpl);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
 
+  mFbBase = Base;
+  mFbNumPages = NumPages;
+  mFbRuntimePages = RuntimePages;
   return EFI_SUCCESS;
 }
 
+STATIC
+VOID
+DisplayFreeFramebuffer (
+  IN EFI_PHYSICAL_ADDRESS Base,
+  IN UINTN                NumPages,
+  IN UINTN                RuntimePages
+  )
+{
+  if (NumPages == 0) {
+    return;
+  }
+
+  gBS->FreePages (Base, RuntimePages);
+  if (NumPages > RuntimePages) {
+    gBS->FreePages (Base + EFI_PAGES_TO_SIZE (RuntimePages),
+      NumPages - RuntimePages);
+  }
+}
+
 STATIC
 VOID
 ClearScreen (
@@ -215,44 +922,85 @@ ClearScreen (
           sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
 }
 
+/**
+  Size the buffers for ModeNumber, fill in the mode information and clear
+  the screen. Scanout is left alone until Vop2SetMode.
+
+**/
 STATIC
 EFI_STATUS
-EFIAPI
-DisplaySetMode (
+DisplaySetModeBuffers (
   IN  EFI_GRAPHICS_OUTPUT_PROTOCOL *This,
   IN  UINT32                       ModeNumber
   )
 {
   UINTN NumPages;
+  UINTN RuntimePages;
   UINTN FbSize;
+  EFI_PHYSICAL_ADDRESS OldFbBase;
+  UINTN OldFbNumPages;
+  UINTN OldFbRuntimePages;
+  UINT8 *ShadowFb;
   EFI_STATUS Status;
-  GOP_MODE_DATA *Mode = &mGopModeData[ModeNumber];
+  EFI_TPL OldTpl;
+  GOP_MODE_DATA *Mode;
 
- if (ModeNumber >= This->Mode->MaxMode) {
+  if (ModeNumber >= This->Mode->MaxMode) {
     return EFI_UNSUPPORTED;
   }
+  Mode = &mGopModeData[ModeNumber];
 
   DEBUG ((DEBUG_INFO, "Setting mode %u from %u: %u x %u\n",
     ModeNumber, This->Mode->Mode, Mode->Width, Mode->Height));
 
-  FbSize = Mode->Width * Mode->Height * RK_BYTES_PER_PIXEL;
+  /* Spare rows for hardware scrolling; see DISPLAY_SCROLL_RATIO */
+  FbSize = DisplayPixelsPerScanLine (Mode->Width) * Mode->Height *
+           DISPLAY_SCROLL_RATIO * mBytesPerPixel;
   NumPages = EFI_SIZE_TO_PAGES (FbSize);
-  if (mFbNumPages < NumPages) {
-    if (mFbNumPages != 0) {
-      gBS->FreePages (mFbBase, mFbNumPages);
-      mFbNumPages = 0;
+  RuntimePages = EFI_SIZE_TO_PAGES (DisplayPixelsPerScanLine (Mode->Width) *
+                                    Mode->Height * mBytesPerPixel);
+
+  /*
+   * Buffers are sized for the mode, so a smaller mode hands memory back.
+   * The new ones are allocated before the old ones are freed, so a failure
+   * leaves the current mode intact.
+   */
+  ShadowFb = mShadowFb;
+  if (mShadowFbNumPages != NumPages) {
+    ShadowFb = AllocatePages (NumPages);
+    if (ShadowFb == NULL) {
+      DEBUG ((DEBUG_ERROR, "Could not allocate %u pages for shadow framebuffer\n", NumPages));
+      return EFI_DEVICE_ERROR;
     }
+  }
 
-    mFbBase = SIZE_4GB - 1;
-    Status = gBS->AllocatePages (AllocateMaxAddress, EfiRuntimeServicesData,
-                                NumPages, &mFbBase);
+  if (mFbNumPages != NumPages || mFbRuntimePages != RuntimePages) {
+    OldFbBase = mFbBase;
+    OldFbNumPages = mFbNumPages;
+    OldFbRuntimePages = mFbRuntimePages;
+    Status = DisplayAllocateFramebuffer (NumPages, RuntimePages);
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "Could not allocate %u pages for mode %u: %r\n", NumPages, ModeNumber, Status));
+      if (ShadowFb != mShadowFb) {
+        FreePages (ShadowFb, NumPages);
+      }
       return EFI_DEVICE_ERROR;
     }
-    mFbNumPages = NumPages;
+    DisplayFreeFramebuffer (OldFbBase, OldFbNumPages, OldFbRuntimePages);
+  }
+
+  if (ShadowFb != mShadowFb) {
+    if (mShadowFbNumPages != 0) {
+      FreePages (mShadowFb, mShadowFbNumPages);
+    }
+    mShadowFb = ShadowFb;
+    mShadowFbNumPages = NumPages;
   }
 
+  mScrollRows = Mode->Height * DISPLAY_SCROLL_RATIO;
+  mScrollOffset = 0;
+  mNumDirtyRects = 0;
+
   DEBUG ((DEBUG_INFO, "Mode %u: %u x %u framebuffer is %u bytes at %p\n",
     ModeNumber, Mode->Width, Mode->Height, FbSize, mFbBase));
 
@@ -286,23 +1034,56 @@ Status = mCpu->SetMemoryAttributes (mCpu, mFbBase,
   /*
    * NOTE: Windows REQUIRES BGR in 32 or 24 bit format.
    */
-  This->Mode->Info->PixelFormat = PixelBlueGreenRedReserved8BitPerColor;
-  This->Mode->Info->PixelsPerScanLine = Mode->Width;
+  if (mBytesPerPixel == 2) {
+    This->Mode->Info->PixelFormat = PixelBitMask;
+    This->Mode->Info->PixelInformation.RedMask = 0xF800;
+    This->Mode->Info->PixelInformation.GreenMask = 0x07E0;
+    This->Mode->Info->PixelInformation.BlueMask = 0x001F;
+    This->Mode->Info->PixelInformation.ReservedMask = 0;
+  } else {
+    This->Mode->Info->PixelFormat = PixelBlueGreenRedReserved8BitPerColor;
+  }
+  This->Mode->Info->PixelsPerScanLine = DisplayPixelsPerScanLine (Mode->Width);
   This->Mode->SizeOfInfo = sizeof (*This->Mode->Info);
   This->Mode->FrameBufferBase = mFbBase;
-  This->Mode->FrameBufferSize = Mode->Width * Mode->Height * RK_BYTES_PER_PIXEL;
+  This->Mode->FrameBufferSize = This->Mode->Info->PixelsPerScanLine * Mode->Height * mBytesPerPixel;
   DEBUG((DEBUG_INFO, "Reported Mode->FrameBufferSize is %u\n", This->Mode->FrameBufferSize));
 
   ClearScreen (This);
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  DisplayFlush (This);
+  gBS->RestoreTPL (OldTpl);
 
-  Vop2SetMode (This->Mode);
+  return EFI_SUCCESS;
+}
+
+/**
+  Switch to another framebuffer size. The HDMI link is started during
+  bring-up; other modes only change the scaler, not the link.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+DisplaySetMode (
+  IN  EFI_GRAPHICS_OUTPUT_PROTOCOL *This,
+  IN  UINT32                       ModeNumber
+  )
+{
+  EFI_STATUS Status;
+
+  Status = DisplaySetModeBuffers (This, ModeNumber);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
 
-  /* Start HDMI TX */
-  DwHdmiEnable (&mPreferredTimings);
+  Vop2SetMode (This->Mode);
 
   return EFI_SUCCESS;
 }
 
+PMU_PROFILE_DEFINE (mBltProfile, "DisplayBlt");
+
 STATIC
 EFI_STATUS
 EFIAPI
@@ -320,7 +1101,9 @@ DisplayBlt (
   )
 {
   UINT8 *VidBuf, *BltBuf, *VidBuf1;
-  UINTN i;
+  UINTN HRes, VRes;
+  UINTN i, Row;
+  EFI_TPL OldTpl;
 
   if ((UINTN)BltOperation >= EfiGraphicsOutputBltOperationMax) {
     return EFI_INVALID_PARAMETER;
@@ -330,63 +1113,422 @@ DisplayBlt (
     return EFI_INVALID_PARAMETER;
   }
 
+  /* The shadow has no guard pages, so keep every access on screen */
+  HRes = This->Mode->Info->HorizontalResolution;
+  VRes = This->Mode->Info->VerticalResolution;
+  if (BltOperation == EfiBltVideoToBltBuffer ||
+      BltOperation == EfiBltVideoToVideo) {
+    if (SourceX + Width > HRes || SourceY + Height > VRes) {
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+  if (BltOperation != EfiBltVideoToBltBuffer) {
+    if (DestinationX + Width > HRes || DestinationY + Height > VRes) {
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  PMU_PROFILE_BEGIN (mBltProfile);
+
   switch (BltOperation) {
   case EfiBltVideoFill:
     BltBuf = (UINT8*)BltBuffer;
 
     for (i = 0; i < Height; i++) {
-      VidBuf = POS_TO_FB (DestinationX, DestinationY + i);
+      VidBuf = POS_TO_SHADOW (DestinationX, DestinationY + i);
 
-      SetMem32 (VidBuf, Width * RK_BYTES_PER_PIXEL, *(UINT32*)BltBuf);
+      if (mBytesPerPixel == 2) {
+        DisplayBltFill16 (VidBuf, DISPLAY_PIXEL_TO_RGB565 (*(UINT32*)BltBuf), Width);
+      } else {
+        DisplayBltFill (VidBuf, *(UINT32*)BltBuf, Width);
+      }
     }
+    DisplayMarkDirty (This, DestinationX, DestinationY, Width, Height);
     break;
 
   case EfiBltVideoToBltBuffer:
     if (Delta == 0) {
-      Delta = Width * RK_BYTES_PER_PIXEL;
+      Delta = Width * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
     }
 
     for (i = 0; i < Height; i++) {
-      VidBuf = POS_TO_FB (SourceX, SourceY + i);
+      VidBuf = POS_TO_SHADOW (SourceX, SourceY + i);
 
       BltBuf = (UINT8*)((UINTN)BltBuffer + (DestinationY + i) * Delta +
-        DestinationX * RK_BYTES_PER_PIXEL);
+        DestinationX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
 
-      gBS->CopyMem ((VOID*)BltBuf, (VOID*)VidBuf, RK_BYTES_PER_PIXEL * Width);
+      if (mBytesPerPixel == 2) {
+        DisplayBltFromRgb565 (BltBuf, VidBuf, Width);
+      } else {
+        DisplayBltCopy (BltBuf, VidBuf, Width);
+      }
     }
     break;
 
   case EfiBltBufferToVideo:
     if (Delta == 0) {
-      Delta = Width * RK_BYTES_PER_PIXEL;
+      Delta = Width * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
     }
 
     for (i = 0; i < Height; i++) {
-      VidBuf = POS_TO_FB (DestinationX, DestinationY + i);
+      VidBuf = POS_TO_SHADOW (DestinationX, DestinationY + i);
       BltBuf = (UINT8*)((UINTN)BltBuffer + (SourceY + i) * Delta +
-        SourceX * RK_BYTES_PER_PIXEL);
+        SourceX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
 
-      gBS->CopyMem ((VOID*)VidBuf, (VOID*)BltBuf, Width * RK_BYTES_PER_PIXEL);
+      if (mBytesPerPixel == 2) {
+        DisplayBltToRgb565 (VidBuf, BltBuf, Width);
+      } else {
+        DisplayBltCopy (VidBuf, BltBuf, Width);
+      }
     }
+    DisplayMarkDirty (This, DestinationX, DestinationY, Width, Height);
     break;
 
   case EfiBltVideoToVideo:
+    if (mHwScrollEnabled && SourceY > DestinationY &&
+        SourceX == 0 && DestinationX == 0 && Width == HRes) {
+      DisplayHwScroll (This, SourceY, DestinationY, Height);
+      break;
+    }
+
     for (i = 0; i < Height; i++) {
-      VidBuf = POS_TO_FB (SourceX, SourceY + i);
-      VidBuf1 = POS_TO_FB (DestinationX, DestinationY + i);
+      /* Walk bottom-up when moving down so overlapping rows survive */
+      Row = DestinationY > SourceY ? Height - 1 - i : i;
+      VidBuf = POS_TO_SHADOW (SourceX, SourceY + Row);
+      VidBuf1 = POS_TO_SHADOW (DestinationX, DestinationY + Row);
 
-      gBS->CopyMem ((VOID*)VidBuf1, (VOID*)VidBuf, Width * RK_BYTES_PER_PIXEL);
+      DisplayCopyPixels (VidBuf1, VidBuf, Width);
     }
+    DisplayMarkDirty (This, DestinationX, DestinationY, Width, Height);
     break;
 
   default:
-    return EFI_INVALID_PARAMETER;
     break;
   }
 
+  PMU_PROFILE_END (mBltProfile);
+  gBS->RestoreTPL (OldTpl);
+
   return EFI_SUCCESS;
 }
 
+/**
+  Release everything bring-up created. GOP must not be installed.
+
+**/
+STATIC
+VOID
+DisplayStartCleanup (
+  VOID
+  )
+{
+  if (mFlushEvent != NULL) {
+    gBS->CloseEvent (mFlushEvent);
+    mFlushEvent = NULL;
+  }
+
+  if (mExitBootServicesEvent != NULL) {
+    gBS->CloseEvent (mExitBootServicesEvent);
+    mExitBootServicesEvent = NULL;
+  }
+
+  if (mReadyToBootEvent != NULL) {
+    gBS->CloseEvent (mReadyToBootEvent);
+    mReadyToBootEvent = NULL;
+  }
+
+  if (mEdidVerifyEvent != NULL) {
+    gBS->CloseEvent (mEdidVerifyEvent);
+    mEdidVerifyEvent = NULL;
+  }
+
+  if (gDisplayProto.Mode != NULL) {
+    if (gDisplayProto.Mode->Info != NULL) {
+      FreePool (gDisplayProto.Mode->Info);
+    }
+    FreePool (gDisplayProto.Mode);
+    gDisplayProto.Mode = NULL;
+  }
+}
+
+/**
+  Pick the pixel format, build the mode list and prepare the buffers for
+  the preferred mode.
+
+**/
+STATIC
+EFI_STATUS
+DisplayStartBuffers (
+  VOID
+  )
+{
+  mPreferredTimings = mStartTimings;
+  DEBUG ((DEBUG_INFO, "Display: Detected %ux%u display\n",
+          mPreferredTimings.HDisplay, mPreferredTimings.VDisplay));
+
+  PcdSet32S (PcdVideoHorizontalResolution, mPreferredTimings.HDisplay);
+  PcdSet32S (PcdVideoVerticalResolution, mPreferredTimings.VDisplay);
+
+  /*
+   * At 16 bpp the framebuffer is RGB565, reported as PixelBitMask, and Blt
+   * converts to and from BGRA8888. That halves scanout bandwidth and the
+   * cost of every copy, at the expense of OS loaders that only handle
+   * 32 bpp (Windows among them).
+   */
+  mBytesPerPixel = PcdGet32 (PcdDisplayColorDepth) == DISPLAY_COLOR_DEPTH_16 ? 2 : 4;
+
+  /* After a monitor change GOP is still installed with its mode */
+  if (gDisplayProto.Mode == NULL) {
+    gDisplayProto.Mode = AllocateZeroPool (sizeof (EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE));
+    if (gDisplayProto.Mode == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    gDisplayProto.Mode->Info = AllocateZeroPool (sizeof (EFI_GRAPHICS_OUTPUT_MODE_INFORMATION));
+    if (gDisplayProto.Mode->Info == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  // Both set up the buffers and initialize current mode information.
+  gDisplayProto.Mode->MaxMode = DisplayBuildModeList ();
+  return DisplaySetModeBuffers (&gDisplayProto, 0);
+}
+
+/**
+  Arm the driver's events and install GOP.
+
+**/
+STATIC
+EFI_STATUS
+DisplayStartInstall (
+  VOID
+  )
+{
+  EFI_STATUS Status;
+
+  /* A new monitor: let GraphicsConsole and friends see the new modes */
+  if (mGopInstalled) {
+    return gBS->ReinstallProtocolInterface (mStartController,
+                  &gEfiGraphicsOutputProtocolGuid, &gDisplayProto,
+                  &gDisplayProto);
+  }
+
+  Status = gBS->CreateEvent (EVT_TIMER | EVT_NOTIFY_SIGNAL, TPL_NOTIFY,
+                  DisplayFlushTimer, NULL, &mFlushEvent);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  Status = gBS->SetTimer (mFlushEvent, TimerPeriodic, DISPLAY_FLUSH_PERIOD);
+  ASSERT_EFI_ERROR (Status);
+
+  Status = gBS->CreateEvent (EVT_SIGNAL_EXIT_BOOT_SERVICES, TPL_NOTIFY,
+                  DisplayExitBootServices, NULL, &mExitBootServicesEvent);
+  ASSERT_EFI_ERROR (Status);
+
+  Status = EfiCreateEventReadyToBootEx (TPL_CALLBACK, DisplayReadyToBoot,
+                  NULL, &mReadyToBootEvent);
+  ASSERT_EFI_ERROR (Status);
+
+  /* Mode set didn't wait for DDC; confirm the cached EDID off the boot path */
+  Status = gBS->CreateEvent (EVT_TIMER | EVT_NOTIFY_SIGNAL, TPL_CALLBACK,
+                  DisplayVerifyEdid, NULL, &mEdidVerifyEvent);
+  if (!EFI_ERROR (Status)) {
+    Status = gBS->SetTimer (mEdidVerifyEvent, TimerRelative, DISPLAY_EDID_VERIFY_DELAY);
+    ASSERT_EFI_ERROR (Status);
+  }
+
+  Status = gBS->InstallMultipleProtocolInterfaces (
+    &mStartController, &gEfiGraphicsOutputProtocolGuid,
+    &gDisplayProto, NULL);
+  if (!EFI_ERROR (Status)) {
+    mGopInstalled = TRUE;
+  }
+  return Status;
+}
+
+/**
+  Run one step of controller bring-up.
+
+  @retval EFI_NOT_READY     More steps remain.
+  @retval EFI_SUCCESS       GOP is installed; the display is running.
+  @retval Others            Bring-up gave up.
+
+**/
+STATIC
+EFI_STATUS
+DisplayStartRunStep (
+  VOID
+  )
+{
+  EFI_STATUS Status;
+
+  switch (mStartState) {
+  case DisplayStateInit:
+    DisplayPowerOn ();
+    DwHdmiPrepare ();
+    mStartState = DisplayStateDetect;
+    return EFI_NOT_READY;
+
+  case DisplayStateDetect:
+    if (!DwHdmiDetect ()) {
+      DEBUG ((DEBUG_INFO, "No display detected\n"));
+      if (PcdGet32 (PcdDisplayPowerPolicy) != DISPLAY_POWER_ALWAYS_ON) {
+        DisplayPowerOff ();
+      }
+      return EFI_NOT_FOUND;
+    }
+    mStartState = DisplayStateEdid;
+    return EFI_NOT_READY;
+
+  case DisplayStateEdid:
+    mStartTimings = mDefaultTimings;
+    if (DwHdmiGetCachedTimings (&mStartTimings)) {
+      mStartState = DisplayStateBuffers;
+    } else {
+      DwHdmiReadEdidStart ();
+      mStartState = DisplayStateEdidRead;
+    }
+    return EFI_NOT_READY;
+
+  case DisplayStateEdidRead:
+    /* One EDID block per step */
+    Status = DwHdmiReadEdidStep (&mStartTimings);
+    if (Status == EFI_NOT_READY) {
+      return EFI_NOT_READY;
+    }
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "Display: No EDID, using default timing\n"));
+      mStartTimings = mDefaultTimings;
+    }
+    mStartState = DisplayStateBuffers;
+    return EFI_NOT_READY;
+
+  case DisplayStateBuffers:
+    Status = DisplayStartBuffers ();
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    mStartState = DisplayStateScanout;
+    return EFI_NOT_READY;
+
+  case DisplayStateScanout:
+    /* Waits for the HPLL to lock */
+    Vop2SetMode (gDisplayProto.Mode);
+    mStartState = DisplayStateLink;
+    return EFI_NOT_READY;
+
+  case DisplayStateLink:
+    /* Start HDMI TX, which waits for the PHY to lock */
+    if (mGopInstalled) {
+      /* Retrain the running link for the new monitor */
+      DwHdmiDisable ();
+      mHdmiEnabled = FALSE;
+    }
+    if (!mHdmiEnabled) {
+      DwHdmiEnable (&mPreferredTimings);
+      mHdmiEnabled = TRUE;
+    }
+    mStartState = DisplayStateInstall;
+    return EFI_NOT_READY;
+
+  case DisplayStateInstall:
+    Status = DisplayStartInstall ();
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    mStartState = DisplayStateRunning;
+    return EFI_SUCCESS;
+
+  default:
+    return EFI_NOT_STARTED;
+  }
+
+  DEBUG ((DEBUG_ERROR, "Could not start DisplayDxe: %r\n", Status));
+  if (!mGopInstalled) {
+    DisplayStartCleanup ();
+  }
+  return Status;
+}
+
+/**
+  Give up on bring-up and release the controller.
+
+**/
+STATIC
+VOID
+DisplayStartAbort (
+  VOID
+  )
+{
+  mStartState = DisplayStateStopped;
+  gBS->CloseProtocol (
+         mStartController,
+         &gEfiCallerIdGuid,
+         mStartDriverBindingHandle,
+         mStartController
+       );
+}
+
+/**
+  Add the display to ConOut. On a first boot or after an NVRAM reset BDS
+  may already have built ConOut from the GOPs it could find, before this
+  one was installed; without the entry ConPlatform won't hand the GOP to
+  ConSplitter when the controller is reconnected.
+
+**/
+STATIC
+VOID
+DisplayAddToConOut (
+  VOID
+  )
+{
+  EFI_STATUS Status;
+
+  Status = EfiBootManagerUpdateConsoleVariable (ConOut,
+             (EFI_DEVICE_PATH_PROTOCOL *)&mDisplayProtoDevicePath, NULL);
+  DEBUG ((DEBUG_INFO, "Display: Add to ConOut: %r\n", Status));
+}
+
+/**
+  Run one step of controller bring-up. Called from a periodic timer armed
+  by DriverStart until the display is running or bring-up gives up.
+
+**/
+STATIC
+VOID
+EFIAPI
+DisplayStartStep (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_STATUS Status;
+
+  Status = DisplayStartRunStep ();
+  if (Status == EFI_NOT_READY) {
+    return;
+  }
+
+  gBS->CloseEvent (mStartEvent);
+  mStartEvent = NULL;
+
+  if (EFI_ERROR (Status) && mGopInstalled) {
+    /* The monitor changed but its mode couldn't be set; keep GOP as is */
+    mStartState = DisplayStateRunning;
+    return;
+  }
+  if (EFI_ERROR (Status)) {
+    DisplayStartAbort ();
+    return;
+  }
+
+  /* Let GraphicsConsole bind now that there is a GOP to bind to */
+  DisplayAddToConOut ();
+  gBS->ConnectController (mStartController, NULL, NULL, TRUE);
+}
+
 /**
    Initialize the state information for the Display Dxe
 
@@ -486,65 +1628,30 @@ DriverStart (
     return Status;
   }
 
-  mPreferredTimings = mDefaultTimings;
-  if (DwHdmiDetect (&mPreferredTimings) == FALSE) {
-    DEBUG ((DEBUG_INFO, "No display detected\n"));
-    Status = EFI_NOT_FOUND;
-    goto Done;
-  }
-  
-  DEBUG ((DEBUG_INFO, "Display: Detected %ux%u display\n",
-          mPreferredTimings.HDisplay, mPreferredTimings.VDisplay));
-
-  PcdSet32S (PcdVideoHorizontalResolution, mPreferredTimings.HDisplay);
-  PcdSet32S (PcdVideoVerticalResolution, mPreferredTimings.VDisplay);
-
-  gDisplayProto.Mode = AllocateZeroPool (sizeof (EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE));
-  if (gDisplayProto.Mode == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Done;
-  }
-
-  gDisplayProto.Mode->Info = AllocateZeroPool (sizeof (EFI_GRAPHICS_OUTPUT_MODE_INFORMATION));
-  if (gDisplayProto.Mode->Info == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Done;
-  }
+  mStartController = Controller;
+  mStartDriverBindingHandle = This->DriverBindingHandle;
+  mStartState = DisplayStateInit;
 
-  mGopModeData[0].Width = PcdGet32 (PcdVideoHorizontalResolution);
-  mGopModeData[0].Height = PcdGet32 (PcdVideoVerticalResolution);
-
-  // Both set the mode and initialize current mode information.
-  gDisplayProto.Mode->MaxMode = ARRAY_SIZE (mGopModeData);
-  DisplaySetMode (&gDisplayProto, 0);
-
-  Status = gBS->InstallMultipleProtocolInterfaces (
-    &Controller, &gEfiGraphicsOutputProtocolGuid,
-    &gDisplayProto, NULL);
-  if (EFI_ERROR (Status)) {
-    goto Done;
+  /*
+   * Run bring-up from a timer, one step per tick, so connecting the
+   * console doesn't wait on the PHY, the PLLs or DDC, even with a cached
+   * EDID. GOP is installed, added to ConOut and the controller reconnected
+   * once a mode is set.
+   */
+  Status = gBS->CreateEvent (EVT_TIMER | EVT_NOTIFY_SIGNAL, TPL_CALLBACK,
+                  DisplayStartStep, NULL, &mStartEvent);
+  if (!EFI_ERROR (Status)) {
+    Status = gBS->SetTimer (mStartEvent, TimerPeriodic, DISPLAY_START_PERIOD);
   }
-
-Done:
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "Could not start DisplayDxe: %r\n", Status));
-    if (gDisplayProto.Mode->Info != NULL) {
-      FreePool (gDisplayProto.Mode->Info);
-      gDisplayProto.Mode->Info = NULL;
-    }
-
-    if (gDisplayProto.Mode != NULL) {
-      FreePool (gDisplayProto.Mode);
-      gDisplayProto.Mode = NULL;
+    if (mStartEvent != NULL) {
+      gBS->CloseEvent (mStartEvent);
+      mStartEvent = NULL;
     }
-
-    gBS->CloseProtocol (
-           Controller,
-           &gEfiCallerIdGuid,
-           This->DriverBindingHandle,
-           Controller
-         );
+    DisplayStartAbort ();
   }
+
   return Status;
 }
 
@@ -559,20 +1666,42 @@ DriverStop (
   )
 {
   EFI_STATUS Status;
+  EFI_TPL OldTpl;
+
+  if (mStartEvent != NULL) {
+    gBS->CloseEvent (mStartEvent);
+    mStartEvent = NULL;
+  }
+
+  if (!mGopInstalled) {
+    /* Bring-up didn't get as far as installing GOP */
+    DisplayStartCleanup ();
+    mStartState = DisplayStateStopped;
+    gBS->CloseProtocol (
+           Controller,
+           &gEfiCallerIdGuid,
+           This->DriverBindingHandle,
+           Controller
+         );
+    return EFI_SUCCESS;
+  }
 
   ClearScreen (&gDisplayProto);
 
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  DisplayFlush (&gDisplayProto);
+  gBS->RestoreTPL (OldTpl);
+
   Status = gBS->UninstallMultipleProtocolInterfaces (
     Controller, &gEfiGraphicsOutputProtocolGuid,
     &gDisplayProto, NULL);
   if (EFI_ERROR (Status)) {
     return Status;
   }
+  mGopInstalled = FALSE;
 
-  FreePool (gDisplayProto.Mode->Info);
-  gDisplayProto.Mode->Info = NULL;
-  FreePool (gDisplayProto.Mode);
-  gDisplayProto.Mode = NULL;
+  DisplayStartCleanup ();
+  mStartState = DisplayStateStopped;
 
   gBS->CloseProtocol (
          Controller,
@@ -48,4 +48,9 @@ typedef struct {
 
 extern HDMI_DISPLAY_TIMING mPreferredTimings;
 
+typedef struct {
+  UINT32 Width;
+  UINT32 Height;
+} GOP_MODE_DATA;
+
 #endif /* _DISPLAY_H_ */
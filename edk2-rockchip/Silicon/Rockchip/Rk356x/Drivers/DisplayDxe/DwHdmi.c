@@ -13,10 +13,28 @@
 #include <IndustryStandard/Rk356x.h>
 #include <Library/CruLib.h>
 #include <Library/GpioLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
 
 /* Maximum number of EDID extension blocks */
 #define MAX_EDID_EXTENSION_BLOCKS   5
 
+/*
+ * The validated EDID and the timing picked from it are kept in a variable.
+ * At the next start the cached copy is used straight away, and only the
+ * vendor/product/serial bytes and checksum are read back over DDC later to
+ * confirm the same monitor is still attached.
+ */
+#define DWHDMI_EDID_CACHE_VARIABLE_NAME   L"HdmiEdidCache"
+#define DWHDMI_EDID_ID_OFFSET             0x08
+#define DWHDMI_EDID_ID_LENGTH             10        /* vendor, product, serial */
+#define DWHDMI_EDID_CHECKSUM_OFFSET       0x7F
+
+typedef struct {
+    UINT8 Edid[128 * (1 + MAX_EDID_EXTENSION_BLOCKS)];
+    UINT8 NumExt;
+    HDMI_DISPLAY_TIMING Timings;
+} DWHDMI_EDID_CACHE;
+
 /* RK356x specific GRF registers */
 #define GRF_VO_CON1         (SYS_GRF + 0x0364)
 #define  HDMI_SDAIN_MSK     BIT15
@@ -50,6 +68,25 @@ DWHDMI_PHY_CONFIG mDwHdmiPhyConfig[] = {
 
 STATIC EFI_EDID_DISCOVERED_PROTOCOL mEdidDiscovered;
 STATIC EFI_EDID_ACTIVE_PROTOCOL mEdidActive;
+STATIC EFI_HANDLE mEdidHandle;
+STATIC DWHDMI_EDID_CACHE mEdidCache;
+STATIC BOOLEAN mEdidCacheValid;
+STATIC BOOLEAN mEdidCacheUsed;
+
+/* EDID read in progress, see DwHdmiReadEdidStep */
+STATIC UINT8 mEdidReadBuf[128 * (1 + MAX_EDID_EXTENSION_BLOCKS)];
+STATIC UINT8 mEdidReadBlock;
+STATIC UINT8 mEdidReadRetry;
+STATIC UINT64 mEdidReadStart;
+
+/* EDID 1.4 section 3.8, established timings I and II, MSB of byte 0x23 first */
+STATIC CONST GOP_MODE_DATA mDwHdmiEstablishedModes[] = {
+        { 720, 400 },   { 720, 400 },   { 640, 480 },   { 640, 480 },
+        { 640, 480 },   { 640, 480 },   { 800, 600 },   { 800, 600 },
+        { 800, 600 },   { 800, 600 },   { 832, 624 },   { 1024, 768 },
+        { 1024, 768 },  { 1024, 768 },  { 1024, 768 },  { 1280, 1024 },
+        { 1152, 870 },
+};
 
 STATIC
 VOID
@@ -281,74 +318,358 @@ DwHdmiParseEdid (
     return TRUE;
 }
 
+/**
+  Publish the EDID through the EDID Discovered and Active protocols. The
+  first call installs them on a handle of their own; later calls keep that
+  handle and reinstall the interfaces, freeing the old buffer only once
+  consumers have been told about the new one.
+
+**/
+STATIC
+VOID
+DwHdmiPublishEdid (
+    IN UINT8 *Edid
+    )
+{
+    EFI_STATUS Status;
+    UINT8 *OldEdid;
+    UINT8 *NewEdid;
+
+    NewEdid = AllocateCopyPool (128, Edid);
+    if (NewEdid == NULL) {
+        return;
+    }
+
+    OldEdid = mEdidDiscovered.Edid;
+    mEdidDiscovered.SizeOfEdid = mEdidActive.SizeOfEdid = 128;
+    mEdidDiscovered.Edid = mEdidActive.Edid = NewEdid;
+
+    if (mEdidHandle == NULL) {
+        Status = gBS->InstallMultipleProtocolInterfaces (
+          &mEdidHandle,
+          &gEfiEdidDiscoveredProtocolGuid,
+          &mEdidDiscovered,
+          &gEfiEdidActiveProtocolGuid,
+          &mEdidActive,
+          NULL);
+        ASSERT (Status == EFI_SUCCESS);
+    } else {
+        Status = gBS->ReinstallProtocolInterface (mEdidHandle,
+                   &gEfiEdidDiscoveredProtocolGuid,
+                   &mEdidDiscovered, &mEdidDiscovered);
+        ASSERT_EFI_ERROR (Status);
+        Status = gBS->ReinstallProtocolInterface (mEdidHandle,
+                   &gEfiEdidActiveProtocolGuid,
+                   &mEdidActive, &mEdidActive);
+        ASSERT_EFI_ERROR (Status);
+    }
+
+    if (OldEdid != NULL) {
+        FreePool (OldEdid);
+    }
+}
+
+STATIC
+VOID
+DwHdmiLoadEdidCache (
+    VOID
+    )
+{
+    EFI_STATUS Status;
+    UINTN Size;
+
+    Size = sizeof (mEdidCache);
+    Status = gRT->GetVariable (DWHDMI_EDID_CACHE_VARIABLE_NAME,
+                    &gRk356xTokenSpaceGuid, NULL, &Size, &mEdidCache);
+    mEdidCacheValid = !EFI_ERROR (Status) && Size == sizeof (mEdidCache) &&
+                      mEdidCache.NumExt <= MAX_EDID_EXTENSION_BLOCKS &&
+                      DwHdmiIsEdidValid (mEdidCache.Edid);
+}
+
+STATIC
+VOID
+DwHdmiSaveEdidCache (
+    IN UINT8 *Edid,
+    IN UINT8 NumExt,
+    IN HDMI_DISPLAY_TIMING *Timings
+    )
+{
+    DWHDMI_EDID_CACHE Cache;
+    EFI_STATUS Status;
+
+    ZeroMem (&Cache, sizeof (Cache));
+    CopyMem (Cache.Edid, Edid, 128 * (1 + NumExt));
+    Cache.NumExt = NumExt;
+    CopyMem (&Cache.Timings, Timings, sizeof (Cache.Timings));
+
+    if (mEdidCacheValid && CompareMem (&Cache, &mEdidCache, sizeof (Cache)) == 0) {
+        return;
+    }
+
+    Status = gRT->SetVariable (DWHDMI_EDID_CACHE_VARIABLE_NAME,
+                    &gRk356xTokenSpaceGuid,
+                    EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                    sizeof (Cache), &Cache);
+    DEBUG ((DEBUG_INFO, "HDMI: Saved EDID cache for %ux%u: %r\n",
+            Timings->HDisplay, Timings->VDisplay, Status));
+    if (!EFI_ERROR (Status)) {
+        CopyMem (&mEdidCache, &Cache, sizeof (Cache));
+        mEdidCacheValid = TRUE;
+    }
+}
+
+/**
+  Confirm that the monitor the cached EDID came from is still attached, by
+  reading back its vendor, product and serial number and the checksum.
+
+  A monitor that can't be read is given the benefit of the doubt. On a
+  mismatch the cache is dropped so the next start reads the full EDID.
+
+  @retval TRUE    The cache was not used, or it matches the monitor.
+  @retval FALSE   A different monitor is attached.
+
+**/
 BOOLEAN
-DwHdmiDetect (
-    OUT HDMI_DISPLAY_TIMING *Timings
+DwHdmiVerifyEdidCache (
+    VOID
     )
 {
-    BOOLEAN Hpd;
     EFI_STATUS Status;
-    UINT8 Buf[128 * (1 + MAX_EDID_EXTENSION_BLOCKS)];
-    EFI_HANDLE Handle;
-    UINT8 Retry;
-    UINT8 NumExt;
+    UINT8 Id[DWHDMI_EDID_ID_LENGTH];
+    UINT8 Checksum;
 
+    if (!mEdidCacheUsed) {
+        return TRUE;
+    }
+
+    Status = DwHdmiEdidReadBytes (0, DWHDMI_EDID_ID_OFFSET, Id, sizeof (Id));
+    if (!EFI_ERROR (Status)) {
+        Status = DwHdmiEdidReadBytes (0, DWHDMI_EDID_CHECKSUM_OFFSET, &Checksum, 1);
+    }
+    if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_WARN, "HDMI: Couldn't verify cached EDID: %r\n", Status));
+        return TRUE;
+    }
+
+    if (CompareMem (Id, &mEdidCache.Edid[DWHDMI_EDID_ID_OFFSET], sizeof (Id)) == 0 &&
+        Checksum == mEdidCache.Edid[DWHDMI_EDID_CHECKSUM_OFFSET]) {
+        DEBUG ((DEBUG_INFO, "HDMI: Cached EDID confirmed\n"));
+        return TRUE;
+    }
+
+    DEBUG ((DEBUG_WARN, "HDMI: Monitor changed, dropping EDID cache\n"));
+    gRT->SetVariable (DWHDMI_EDID_CACHE_VARIABLE_NAME, &gRk356xTokenSpaceGuid,
+      0, 0, NULL);
+    mEdidCacheValid = FALSE;
+    mEdidCacheUsed = FALSE;
+
+    return FALSE;
+}
+
+VOID
+DwHdmiPrepare (
+    VOID
+    )
+{
     /* Configure IOMUX */
     DwHdmiIomuxSetup ();
 
     /* Init DW HDMI */
     DwHdmiInit ();
     DwHdmiPhyInit (NULL);
+}
+
+BOOLEAN
+DwHdmiDetect (
+    VOID
+    )
+{
+    BOOLEAN Hpd;
 
     Hpd = DwHdmiPhyDetect ();
     DEBUG ((DEBUG_INFO, "HDMI: Plug %adetected\n", Hpd ? "" : "not "));
-    if (!Hpd) {
+
+    return Hpd;
+}
+
+/**
+  Take the display timing from the EDID cache, if there is one, and
+  publish the cached EDID. DwHdmiPrepare must have been called.
+
+  @retval TRUE    Timings is set from the cache.
+  @retval FALSE   There is no cache; read the EDID with DwHdmiReadEdidStep.
+
+**/
+BOOLEAN
+DwHdmiGetCachedTimings (
+    OUT HDMI_DISPLAY_TIMING *Timings
+    )
+{
+    DwHdmiLoadEdidCache ();
+    if (!mEdidCacheValid) {
         return FALSE;
     }
 
-    for (Retry = 0; Retry < 5; Retry++) {
-        Status = DwHdmiEdidRead (0, &Buf[0], 128);
-        if (Status == EFI_SUCCESS) {
-            break;
+    DEBUG ((DEBUG_INFO, "HDMI: Using cached EDID, %ux%u\n",
+            mEdidCache.Timings.HDisplay, mEdidCache.Timings.VDisplay));
+    CopyMem (Timings, &mEdidCache.Timings, sizeof (*Timings));
+    DwHdmiPublishEdid (mEdidCache.Edid);
+    mEdidCacheUsed = TRUE;
+    return TRUE;
+}
+
+/**
+  Start reading the EDID over DDC with DwHdmiReadEdidStep.
+
+**/
+VOID
+DwHdmiReadEdidStart (
+    VOID
+    )
+{
+    mEdidReadBlock = 0;
+    mEdidReadRetry = 0;
+    mEdidReadStart = GetPerformanceCounter ();
+}
+
+/**
+  Read the next EDID block over DDC, so a caller on a timer never waits
+  for more than one block. Once all blocks are in, pick a timing from the
+  EDID, publish it and refresh the cache. Only touches the DDC master, so
+  it is safe with the display running.
+
+  @param[out] Timings   Timing picked from the EDID.
+
+  @retval EFI_NOT_READY     A block was read or retried; call again.
+  @retval EFI_SUCCESS       Timings is valid, from the EDID or left as it
+                            was if the EDID can't be used.
+  @retval EFI_DEVICE_ERROR  The EDID couldn't be read.
+
+**/
+EFI_STATUS
+DwHdmiReadEdidStep (
+    OUT HDMI_DISPLAY_TIMING *Timings
+    )
+{
+    EFI_STATUS Status;
+    UINT8 NumExt;
+
+    Status = DwHdmiEdidRead (mEdidReadBlock, &mEdidReadBuf[128 * mEdidReadBlock], 128);
+    if (mEdidReadBlock == 0) {
+        if (EFI_ERROR (Status)) {
+            if (++mEdidReadRetry < 5) {
+                return EFI_NOT_READY;
+            }
+            DEBUG ((DEBUG_WARN, "HDMI: EDID DDC read failed: %r\n", Status));
+            return EFI_DEVICE_ERROR;
         }
+        mEdidReadBlock++;
+    } else if (!EFI_ERROR (Status)) {
+        mEdidReadBlock++;
     }
-    if (EFI_ERROR (Status)) {
-        DEBUG ((DEBUG_WARN, "HDMI: EDID DDC read failed: %r\n", Status));
-        return FALSE;
+
+    /* Extension blocks are best effort: stop at the first one that fails */
+    NumExt = mEdidReadBlock - 1;
+    if (!EFI_ERROR (Status) &&
+        NumExt < MIN (MAX_EDID_EXTENSION_BLOCKS, mEdidReadBuf[126])) {
+        return EFI_NOT_READY;
     }
 
-    for (NumExt = 0; NumExt < MIN (MAX_EDID_EXTENSION_BLOCKS, Buf[126]); NumExt++) {
-        Status = DwHdmiEdidRead (1 + NumExt, &Buf[128 + (1 + NumExt)], 128);
-        if (Status != EFI_SUCCESS) {
-            break;
+    DEBUG ((DEBUG_INFO, "HDMI: Read %u extention blocks (of possible %u) in %lu us\n", NumExt, mEdidReadBuf[126],
+            DivU64x32 (GetTimeInNanoSecond (GetPerformanceCounter () - mEdidReadStart), 1000)));
+    if (DwHdmiParseEdid (mEdidReadBuf, Timings, NumExt) == FALSE) {
+        // There was something we didn't like about the EDID, but return success anyway so we can just
+        // use the default display mode.
+        return EFI_SUCCESS;
+    }
+
+    DwHdmiPublishEdid (mEdidReadBuf);
+    DwHdmiSaveEdidCache (mEdidReadBuf, NumExt, Timings);
+
+    return EFI_SUCCESS;
+}
+
+STATIC
+UINTN
+DwHdmiAddMode (
+    IN OUT GOP_MODE_DATA *Modes,
+    IN UINTN NumModes,
+    IN UINTN MaxModes,
+    IN UINT32 Width,
+    IN UINT32 Height
+    )
+{
+    UINTN Index;
+
+    for (Index = 0; Index < NumModes; Index++) {
+        if (Modes[Index].Width == Width && Modes[Index].Height == Height) {
+            return NumModes;
         }
     }
+    if (NumModes == MaxModes) {
+        return NumModes;
+    }
 
-    DEBUG ((DEBUG_INFO, "HDMI: Read %u extention blocks (of possible %u)\n", NumExt, Buf[126]));
-    if (DwHdmiParseEdid (Buf, Timings, NumExt) == FALSE) {
-        // There was something we didn't like about the EDID, but return TRUE anyway so we can just
-        // use the default display mode.
-        return TRUE;
+    Modes[NumModes].Width = Width;
+    Modes[NumModes].Height = Height;
+    return NumModes + 1;
+}
+
+UINTN
+DwHdmiGetEdidModes (
+    OUT GOP_MODE_DATA *Modes,
+    IN UINTN MaxModes
+    )
+{
+    CONST UINT8 *Edid;
+    UINTN NumModes;
+    UINTN Index;
+    UINT32 Established;
+    UINT32 Width, Height;
+
+    Edid = mEdidDiscovered.Edid;
+    if (Edid == NULL) {
+        return 0;
     }
 
-    if (mEdidDiscovered.Edid != NULL) {
-        FreePool (mEdidDiscovered.Edid);
+    NumModes = 0;
+
+    Established = (Edid[0x23] << 16) | (Edid[0x24] << 8) | Edid[0x25];
+    for (Index = 0; Index < ARRAY_SIZE (mDwHdmiEstablishedModes); Index++) {
+        if ((Established & (BIT23 >> Index)) != 0) {
+            NumModes = DwHdmiAddMode (Modes, NumModes, MaxModes,
+                                      mDwHdmiEstablishedModes[Index].Width,
+                                      mDwHdmiEstablishedModes[Index].Height);
+        }
     }
-    mEdidDiscovered.SizeOfEdid = mEdidActive.SizeOfEdid = 128;
-    mEdidDiscovered.Edid = mEdidActive.Edid = AllocateCopyPool (mEdidDiscovered.SizeOfEdid, Buf);
-    ASSERT (mEdidDiscovered.Edid != NULL);
-
-    Handle = NULL;
-    Status = gBS->InstallMultipleProtocolInterfaces (
-      &Handle,
-      &gEfiEdidDiscoveredProtocolGuid,
-      &mEdidDiscovered,
-      &gEfiEdidActiveProtocolGuid,
-      &mEdidActive,
-      NULL);
-    ASSERT (Status == EFI_SUCCESS);
 
-    return TRUE;
+    /* Standard timings, 8 two byte descriptors starting at 0x26 */
+    for (Index = 0x26; Index < 0x36; Index += 2) {
+        if (Edid[Index] == 0x01 && Edid[Index + 1] == 0x01) {
+            continue;
+        }
+        Width = (Edid[Index] + 31) * 8;
+        switch (Edid[Index + 1] >> 6) {
+        case 0:
+            /* 16:10 since EDID 1.3, 1:1 before */
+            Height = Edid[0x13] >= 3 ? Width * 10 / 16 : Width;
+            break;
+        case 1:
+            Height = Width * 3 / 4;
+            break;
+        case 2:
+            Height = Width * 4 / 5;
+            break;
+        default:
+            Height = Width * 9 / 16;
+            break;
+        }
+        NumModes = DwHdmiAddMode (Modes, NumModes, MaxModes, Width, Height);
+    }
+
+    DEBUG ((DEBUG_INFO, "HDMI: %u resolutions from EDID established/standard timings\n", NumModes));
+
+    return NumModes;
 }
 
 VOID
@@ -359,3 +680,17 @@ DwHdmiEnable (
     DwHdmiBridgeEnable (Timings);
     DwHdmiPhyInit (Timings);
 }
+
+/**
+  Stop the TMDS link and power down the PHY, e.g. before the VO power
+  domain is switched off.
+
+**/
+VOID
+DwHdmiDisable (
+    VOID
+    )
+{
+    DwHdmiPhyPowerOff ();
+    DwHdmiBridgeDisable ();
+}
@@ -45,6 +45,11 @@ DwHdmiEnable (
     IN HDMI_DISPLAY_TIMING *Timings
     );
 
+VOID
+DwHdmiDisable (
+    VOID
+    );
+
 VOID
 DwHdmiInit (
 	VOID
@@ -55,11 +60,21 @@ DwHdmiBridgeEnable (
 	HDMI_DISPLAY_TIMING *Timings
 	);
 
+VOID
+DwHdmiBridgeDisable (
+	VOID
+	);
+
 BOOLEAN
 DwHdmiPhyDetect (
 	VOID
 	);
 
+VOID
+DwHdmiPhyPowerOff (
+	VOID
+	);
+
 VOID
 DwHdmiPhyInit (
 	HDMI_DISPLAY_TIMING *Timings
@@ -71,6 +86,13 @@ DwHdmiEdidRead (
 	OUT UINT8 *buf,
 	IN UINTN len);
 
+EFI_STATUS
+DwHdmiEdidReadBytes (
+	IN UINT8 block,
+	IN UINT8 start,
+	OUT UINT8 *buf,
+	IN UINTN len);
+
 EFI_STATUS
 DwHdmiScdcRead (
 	IN UINT8 Register,
@@ -83,9 +105,40 @@ DwHdmiScdcWrite (
 	IN UINT8 Value
 	);
 
+VOID
+DwHdmiPrepare (
+    VOID
+    );
+
 BOOLEAN
 DwHdmiDetect (
+    VOID
+    );
+
+BOOLEAN
+DwHdmiGetCachedTimings (
     OUT HDMI_DISPLAY_TIMING *Timings
     );
 
+VOID
+DwHdmiReadEdidStart (
+    VOID
+    );
+
+EFI_STATUS
+DwHdmiReadEdidStep (
+    OUT HDMI_DISPLAY_TIMING *Timings
+    );
+
+BOOLEAN
+DwHdmiVerifyEdidCache (
+    VOID
+    );
+
+UINTN
+DwHdmiGetEdidModes (
+    OUT GOP_MODE_DATA *Modes,
+    IN UINTN MaxModes
+    );
+
 #endif /* _DWHDMI_H_ */
\ No newline at end of file
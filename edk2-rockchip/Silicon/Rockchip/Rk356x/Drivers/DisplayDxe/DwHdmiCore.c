@@ -36,6 +36,13 @@
 #define	DDC_SEGMENT_ADDR	0x30
 #define SCDC_ADDR			0x54
 
+/*
+ * DDC/SCDC byte transfers take a few hundred microseconds at 100 kHz, so
+ * poll for completion in small steps instead of sleeping 1 ms per byte.
+ */
+#define	DWHDMI_I2CM_POLL_US		10
+#define	DWHDMI_I2CM_TIMEOUT_US		10000000
+
 #define	HDMI_DESIGN_ID		0x0000
 #define	HDMI_REVISION_ID	0x0001
 #define	HDMI_CONFIG0_ID		0x0004
@@ -257,6 +264,16 @@ DwHdmiEdidRead (
 	IN UINT8 block,
 	OUT UINT8 *buf,
 	IN UINTN len)
+{
+	return DwHdmiEdidReadBytes (block, 0, buf, len);
+}
+
+EFI_STATUS
+DwHdmiEdidReadBytes (
+	IN UINT8 block,
+	IN UINT8 start,
+	OUT UINT8 *buf,
+	IN UINTN len)
 {
 	UINT8 operation, val;
 	UINT8 *pbuf = buf;
@@ -264,7 +281,7 @@ DwHdmiEdidRead (
 
 	ASSERT (buf != NULL);
 	ASSERT (len > 0);
-	ASSERT (len <= 256);
+	ASSERT (start + len <= 128);
 
 	DwHdmiWrite (HDMI_I2CM_SOFTRSTZ, 0);
 	DwHdmiWrite (HDMI_IH_I2CM_STAT0, DwHdmiRead (HDMI_IH_I2CM_STAT0));
@@ -276,15 +293,15 @@ DwHdmiEdidRead (
 	DwHdmiWrite (HDMI_I2CM_SEGADDR, DDC_SEGMENT_ADDR);
 
 	operation = block ? HDMI_I2CM_OPERATION_RD_EXT : HDMI_I2CM_OPERATION_RD;
-	off = (block & 1) ? 128 : 0;
+	off = ((block & 1) ? 128 : 0) + start;
 
 	DwHdmiWrite (HDMI_I2CM_SEGPTR, block >> 1);
 
 	for (n = 0; n < len; n++) {
 		DwHdmiWrite (HDMI_I2CM_ADDRESS, n + off);
 		DwHdmiWrite (HDMI_I2CM_OPERATION, operation);
-		for (retry = 10000; retry > 0; retry--) {
-			MicroSecondDelay (1000);
+		for (retry = DWHDMI_I2CM_TIMEOUT_US / DWHDMI_I2CM_POLL_US; retry > 0; retry--) {
+			MicroSecondDelay (DWHDMI_I2CM_POLL_US);
 			val = DwHdmiRead (HDMI_IH_I2CM_STAT0);
 			if (val & HDMI_IH_I2CM_STAT0_ERROR) {
 				DEBUG ((DEBUG_WARN, "DwHdmiDdcExec: Error! I2CM_STAT0 = 0x%X\n", val));
@@ -327,8 +344,8 @@ DwHdmiScdcRead (
 
 	DwHdmiWrite (HDMI_I2CM_ADDRESS, Register);
 	DwHdmiWrite (HDMI_I2CM_OPERATION, HDMI_I2CM_OPERATION_RD);
-	for (Retry = 10000; Retry > 0; Retry--) {
-		MicroSecondDelay (1000);
+	for (Retry = DWHDMI_I2CM_TIMEOUT_US / DWHDMI_I2CM_POLL_US; Retry > 0; Retry--) {
+		MicroSecondDelay (DWHDMI_I2CM_POLL_US);
 		Val = DwHdmiRead (HDMI_IH_I2CM_STAT0);
 		if (Val & HDMI_IH_I2CM_STAT0_ERROR) {
 			DEBUG ((DEBUG_WARN, "DwHdmiScdcRead: Error! I2CM_STAT0 = 0x%X\n", Val));
@@ -369,8 +386,8 @@ DwHdmiScdcWrite (
 
 	DwHdmiWrite (HDMI_I2CM_ADDRESS, Register);
 	DwHdmiWrite (HDMI_I2CM_OPERATION, HDMI_I2CM_OPERATION_WR);
-	for (Retry = 10000; Retry > 0; Retry--) {
-		MicroSecondDelay (1000);
+	for (Retry = DWHDMI_I2CM_TIMEOUT_US / DWHDMI_I2CM_POLL_US; Retry > 0; Retry--) {
+		MicroSecondDelay (DWHDMI_I2CM_POLL_US);
 		Val = DwHdmiRead (HDMI_IH_I2CM_STAT0);
 		if (Val & HDMI_IH_I2CM_STAT0_ERROR) {
 			DEBUG ((DEBUG_WARN, "DwHdmiScdcWrite: Error! I2CM_STAT0 = 0x%X\n", Val));
@@ -682,6 +699,21 @@ DwHdmiBridgeEnable (
 	}
 }
 
+VOID
+DwHdmiBridgeDisable (
+	VOID
+	)
+{
+	DwHdmiWrite (HDMI_MC_CLKDIS,
+	    HDMI_MC_CLKDIS_HDCPCLK_DISABLE |
+	    HDMI_MC_CLKDIS_CECCLK_DISABLE |
+	    HDMI_MC_CLKDIS_CSCCLK_DISABLE |
+	    HDMI_MC_CLKDIS_AUDCLK_DISABLE |
+	    HDMI_MC_CLKDIS_PREPCLK_DISABLE |
+	    HDMI_MC_CLKDIS_TMDSCLK_DISABLE |
+	    HDMI_MC_CLKDIS_PIXELCLK_DISABLE);
+}
+
 VOID
 DwHdmiInit (
 	VOID
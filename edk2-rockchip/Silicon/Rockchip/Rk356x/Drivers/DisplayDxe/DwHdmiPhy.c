@@ -113,6 +113,11 @@
 #define	  HDMI_MC_HEACPHY_RST_ASSERT            0x1
 #define	  HDMI_MC_HEACPHY_RST_DEASSERT          0x0
 
+/* Status polling: interval, PHY I2C write timeout and TX PLL lock timeout */
+#define	DWHDMI_PHY_POLL_US		10
+#define	DWHDMI_PHY_I2C_TIMEOUT_US	100000
+#define	DWHDMI_PHY_LOCK_TIMEOUT_US	5000
+
 /* HDMI PHY register with access through I2C */
 #define	HDMI_PHY_I2C_CKCALCTRL	0x5
 #define	  CKCALCTRL_OVERRIDE	(1 << 15)
@@ -145,7 +150,7 @@
 STATIC
 VOID
 DwHdmiPhyWaitI2cDone (
-	int msec
+	UINT32 usec
 	)
 {
 	UINT8 val;
@@ -153,10 +158,12 @@ DwHdmiPhyWaitI2cDone (
 	val = DwHdmiRead (HDMI_IH_I2CMPHY_STAT0) &
 	    (HDMI_IH_I2CMPHY_STAT0_DONE | HDMI_IH_I2CMPHY_STAT0_ERROR);
 	while (val == 0) {
-		MicroSecondDelay (1000);
-		msec -= 10;
-		if (msec <= 0)
+		if (usec < DWHDMI_PHY_POLL_US) {
+			DEBUG ((DEBUG_WARN, "HDMI: PHY I2C write timed out\n"));
 			return;
+		}
+		MicroSecondDelay (DWHDMI_PHY_POLL_US);
+		usec -= DWHDMI_PHY_POLL_US;
 		val = DwHdmiRead (HDMI_IH_I2CMPHY_STAT0) &
 		    (HDMI_IH_I2CMPHY_STAT0_DONE | HDMI_IH_I2CMPHY_STAT0_ERROR);
 	}
@@ -176,7 +183,7 @@ DwHdmiPhyI2cWrite (
 	DwHdmiWrite (HDMI_PHY_I2CM_DATAO_1_ADDR, ((data >> 8) & 0xff));
 	DwHdmiWrite (HDMI_PHY_I2CM_DATAO_0_ADDR, ((data >> 0) & 0xff));
 	DwHdmiWrite (HDMI_PHY_I2CM_OPERATION_ADDR, HDMI_PHY_I2CM_OPERATION_ADDR_WRITE);
-	DwHdmiPhyWaitI2cDone (1000);
+	DwHdmiPhyWaitI2cDone (DWHDMI_PHY_I2C_TIMEOUT_US);
 }
 
 STATIC
@@ -301,7 +308,8 @@ DwHdmiPhyConfigure (
 	const DWHDMI_MPLL_CONFIG *mpll_conf;
 	const DWHDMI_PHY_CONFIG *phy_conf;
 	UINT8 val;
-	UINT8 msec;
+	UINT32 usec;
+	UINT64 start;
 
 	DwHdmiWrite (HDMI_MC_FLOWCTRL, HDMI_MC_FLOWCTRL_FEED_THROUGH_OFF_CSC_BYPASS);
 
@@ -376,18 +384,23 @@ DwHdmiPhyConfigure (
 		break;
 	}
 
-	/*Wait for PHY PLL lock */
-	msec = 4;
+	/* Wait for PHY PLL lock */
+	start = GetPerformanceCounter ();
+	usec = DWHDMI_PHY_LOCK_TIMEOUT_US;
 	val = DwHdmiRead (HDMI_PHY_STAT0) & HDMI_PHY_TX_PHY_LOCK;
 	while (val == 0) {
-		MicroSecondDelay (1000);
-		if (msec-- == 0) {
+		if (usec < DWHDMI_PHY_POLL_US) {
 			DEBUG ((DEBUG_WARN, "HDMI: PHY PLL not locked\n"));
 			return EFI_DEVICE_ERROR;
 		}
+		MicroSecondDelay (DWHDMI_PHY_POLL_US);
+		usec -= DWHDMI_PHY_POLL_US;
 		val = DwHdmiRead (HDMI_PHY_STAT0) & HDMI_PHY_TX_PHY_LOCK;
 	}
 
+	DEBUG ((DEBUG_INFO, "HDMI: PHY PLL locked in %lu us\n",
+	    DivU64x32 (GetTimeInNanoSecond (GetPerformanceCounter () - start), 1000)));
+
 	return EFI_SUCCESS;
 }
 
@@ -410,6 +423,17 @@ DwHdmiPhyInit (
 	}
 }
 
+VOID
+DwHdmiPhyPowerOff (
+	VOID
+	)
+{
+	DwHdmiPhyEnableTmds (0);
+	DwHdmiPhyGen2Txpwron (0);
+	DwHdmiPhyGen2Pddq (1);
+	DwHdmiPhyEnablePower (0);
+}
+
 BOOLEAN
 DwHdmiPhyDetect (
 	VOID
@@ -0,0 +1,22 @@
+/** @file
+ *
+ *  ASM_FUNC from ArmPkg's AsmMacroIoLibV8.h, for building BltNeon.S as part
+ *  of a Linux program.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#ifndef _BLT_TEST_ASM_MACRO_IO_LIB_V8_H_
+#define _BLT_TEST_ASM_MACRO_IO_LIB_V8_H_
+
+#define ASM_FUNC(Name)                    \
+  .text                                 ; \
+  .p2align 2                            ; \
+  .global Name                          ; \
+  .type Name, %function                 ; \
+Name:
+
+#endif /* _BLT_TEST_ASM_MACRO_IO_LIB_V8_H_ */
@@ -0,0 +1,39 @@
+/** @file
+ *
+ *  Just enough of MdePkg's Base.h to build the Blt kernels as a Linux
+ *  program for BltTest.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#ifndef _BLT_TEST_BASE_H_
+#define _BLT_TEST_BASE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined (__aarch64__)
+#define MDE_CPU_AARCH64
+#endif
+
+typedef uint8_t   UINT8;
+typedef uint16_t  UINT16;
+typedef uint32_t  UINT32;
+typedef uint64_t  UINT64;
+typedef uintptr_t UINTN;
+typedef intptr_t  INTN;
+typedef UINT8     BOOLEAN;
+typedef void      VOID;
+
+#define CONST     const
+#define STATIC    static
+#define IN
+#define OUT
+#define EFIAPI
+#define TRUE      ((BOOLEAN)1)
+#define FALSE     ((BOOLEAN)0)
+
+#endif /* _BLT_TEST_BASE_H_ */
@@ -0,0 +1,363 @@
+/** @file
+ *
+ *  Host test for the DisplayBlt pixel row kernels.
+ *
+ *  Built as a Linux program together with BltGeneric.c and, on AArch64,
+ *  AArch64/BltNeon.S. Every kernel runs against a reference on two copies
+ *  of the same random buffer, which are then compared in full, so stray
+ *  stores before or after the row are caught as well. DisplayBltFill and
+ *  DisplayBltCopy are checked against their *Generic versions, the 16 bpp
+ *  wrappers against plain 16-bit loops.
+ *
+ *  Afterwards DisplayBltFill and DisplayBltCopy are timed against their
+ *  *Generic versions over a 1080p frame. The numbers are only reported,
+ *  and only mean something on real hardware: under qemu-aarch64 they
+ *  measure the emulator.
+ *
+ *  On an x86 host this only checks the C fallbacks. Run it under
+ *  qemu-aarch64 (see "make test") to check the NEON code.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <Base.h>
+
+#include "BltSupport.h"
+
+#define ARRAY_SIZE(Array)   (sizeof (Array) / sizeof ((Array)[0]))
+
+#define BUFFER_SIZE         16384
+#define BUFFER_MIDDLE       (BUFFER_SIZE / 2)
+
+/* Furthest overlap between source and destination, in bytes */
+#define MAX_OVERLAP         260
+
+/* Timed runs work on a 32 bpp 1080p frame, large enough to miss the caches */
+#define BENCH_WIDTH         1920
+#define BENCH_HEIGHT        1080
+#define BENCH_FRAMES        20
+
+STATIC UINT8 mGot[BUFFER_SIZE] __attribute__ ((aligned (64)));
+STATIC UINT8 mWant[BUFFER_SIZE] __attribute__ ((aligned (64)));
+STATIC UINT8 mNoise[2 * BUFFER_SIZE];
+STATIC UINTN mNoiseStart;
+STATIC UINTN mFailures;
+STATIC UINTN mChecks;
+STATIC UINT32 mFrame[BENCH_WIDTH * BENCH_HEIGHT];
+STATIC UINT32 mFrameSrc[BENCH_WIDTH * BENCH_HEIGHT];
+
+typedef
+VOID
+(EFIAPI *FILL_FUNCTION)(
+  OUT VOID    *Dst,
+  IN  UINT32  Pixel,
+  IN  UINTN   Count
+  );
+
+typedef
+VOID
+(EFIAPI *COPY_FUNCTION)(
+  OUT VOID        *Dst,
+  IN  CONST VOID  *Src,
+  IN  UINTN       Count
+  );
+
+/* Pixel counts: everything up to a few 64-byte blocks, then some large rows */
+STATIC CONST UINTN mLargeCounts[] = {
+  255, 256, 257, 511, 1023, 1024, 1025, 1500, 1919, 1920,
+};
+#define SMALL_COUNT_MAX     140
+
+STATIC
+UINTN
+CountAt (
+  IN UINTN Index
+  )
+{
+  if (Index <= SMALL_COUNT_MAX) {
+    return Index;
+  }
+  return mLargeCounts[Index - SMALL_COUNT_MAX - 1];
+}
+#define NUM_COUNTS          (SMALL_COUNT_MAX + 1 + ARRAY_SIZE (mLargeCounts))
+
+STATIC
+VOID
+RandomizeBuffers (
+  VOID
+  )
+{
+  /* A different window of the noise each time, without calling rand () per byte */
+  mNoiseStart = (mNoiseStart + 4099) % BUFFER_SIZE;
+  memcpy (mGot, mNoise + mNoiseStart, BUFFER_SIZE);
+  memcpy (mWant, mGot, BUFFER_SIZE);
+}
+
+STATIC
+VOID
+CheckBuffers (
+  IN CONST char *Name,
+  IN UINTN      Count,
+  IN INTN       DstOffset,
+  IN INTN       SrcOffset
+  )
+{
+  UINTN Index;
+
+  mChecks++;
+  if (memcmp (mGot, mWant, BUFFER_SIZE) == 0) {
+    return;
+  }
+
+  for (Index = 0; mGot[Index] == mWant[Index]; Index++) {
+  }
+  printf ("FAIL %s: count %lu dst %+ld src %+ld: byte %+ld is 0x%02x, expected 0x%02x\n",
+          Name, (unsigned long)Count, (long)DstOffset, (long)SrcOffset,
+          (long)(Index - BUFFER_MIDDLE), mGot[Index], mWant[Index]);
+  mFailures++;
+}
+
+STATIC
+VOID
+TestFill (
+  VOID
+  )
+{
+  UINTN CountIndex;
+  UINTN Count;
+  INTN Offset;
+  UINT32 Pixel;
+
+  for (CountIndex = 0; CountIndex < NUM_COUNTS; CountIndex++) {
+    Count = CountAt (CountIndex);
+    for (Offset = 0; Offset < 16; Offset += 2) {
+      RandomizeBuffers ();
+      Pixel = (UINT32)rand () ^ ((UINT32)rand () << 16);
+      DisplayBltFill (mGot + BUFFER_MIDDLE + Offset, Pixel, Count);
+      DisplayBltFillGeneric (mWant + BUFFER_MIDDLE + Offset, Pixel, Count);
+      CheckBuffers ("DisplayBltFill", Count, Offset, 0);
+    }
+  }
+}
+
+/*
+ * Source at the middle of the buffer, destination Distance bytes away.
+ * Distances under the row length overlap in either direction.
+ */
+STATIC
+VOID
+TestCopy (
+  VOID
+  )
+{
+  UINTN CountIndex;
+  UINTN Count;
+  INTN Distance;
+  INTN DstAlign;
+  INTN SrcAlign;
+
+  for (CountIndex = 0; CountIndex < NUM_COUNTS; CountIndex++) {
+    Count = CountAt (CountIndex);
+    for (Distance = -MAX_OVERLAP; Distance <= MAX_OVERLAP; Distance += 2) {
+      RandomizeBuffers ();
+      DisplayBltCopy (mGot + BUFFER_MIDDLE + Distance, mGot + BUFFER_MIDDLE, Count);
+      DisplayBltCopyGeneric (mWant + BUFFER_MIDDLE + Distance, mWant + BUFFER_MIDDLE, Count);
+      CheckBuffers ("DisplayBltCopy", Count, Distance, 0);
+    }
+
+    /* Far apart, with every combination of 16-byte alignments */
+    for (DstAlign = 0; DstAlign < 16; DstAlign += 2) {
+      for (SrcAlign = 0; SrcAlign < 16; SrcAlign += 2) {
+        RandomizeBuffers ();
+        DisplayBltCopy (mGot + 64 + DstAlign, mGot + BUFFER_MIDDLE + SrcAlign, Count);
+        DisplayBltCopyGeneric (mWant + 64 + DstAlign, mWant + BUFFER_MIDDLE + SrcAlign, Count);
+        CheckBuffers ("DisplayBltCopy", Count, 64 + DstAlign - BUFFER_MIDDLE, SrcAlign);
+      }
+    }
+  }
+}
+
+STATIC
+VOID
+TestFill16 (
+  VOID
+  )
+{
+  UINTN CountIndex;
+  UINTN Count;
+  INTN Offset;
+  UINT16 Pixel;
+  UINT16 *Want;
+  UINTN Index;
+
+  for (CountIndex = 0; CountIndex < NUM_COUNTS; CountIndex++) {
+    Count = CountAt (CountIndex);
+    for (Offset = 0; Offset < 16; Offset += 2) {
+      RandomizeBuffers ();
+      Pixel = (UINT16)rand ();
+      DisplayBltFill16 (mGot + BUFFER_MIDDLE + Offset, Pixel, Count);
+      Want = (UINT16 *)(mWant + BUFFER_MIDDLE + Offset);
+      for (Index = 0; Index < Count; Index++) {
+        Want[Index] = Pixel;
+      }
+      CheckBuffers ("DisplayBltFill16", Count, Offset, 0);
+    }
+  }
+}
+
+STATIC
+VOID
+TestCopy16 (
+  VOID
+  )
+{
+  UINTN CountIndex;
+  UINTN Count;
+  INTN Distance;
+
+  for (CountIndex = 0; CountIndex < NUM_COUNTS; CountIndex++) {
+    Count = CountAt (CountIndex);
+    for (Distance = -MAX_OVERLAP; Distance <= MAX_OVERLAP; Distance += 2) {
+      RandomizeBuffers ();
+      DisplayBltCopy16 (mGot + BUFFER_MIDDLE + Distance, mGot + BUFFER_MIDDLE, Count);
+      memmove (mWant + BUFFER_MIDDLE + Distance, mWant + BUFFER_MIDDLE, Count * sizeof (UINT16));
+      CheckBuffers ("DisplayBltCopy16", Count, Distance, 0);
+    }
+  }
+}
+
+STATIC
+double
+NowSeconds (
+  VOID
+  )
+{
+  struct timespec Now;
+
+  clock_gettime (CLOCK_MONOTONIC, &Now);
+  return Now.tv_sec + Now.tv_nsec / 1e9;
+}
+
+STATIC
+VOID
+PrintRate (
+  IN CONST char *Name,
+  IN double     Start
+  )
+{
+  double Bytes;
+
+  Bytes = (double)sizeof (mFrame) * BENCH_FRAMES;
+  printf ("  %-32s %6.0f MiB/s\n", Name, Bytes / (NowSeconds () - Start) / (1024 * 1024));
+}
+
+/* Fill every row of the frame, like a full screen EfiBltVideoFill */
+STATIC
+VOID
+BenchFill (
+  IN CONST char     *Name,
+  IN FILL_FUNCTION  Fill
+  )
+{
+  UINTN Frame;
+  UINTN Row;
+  double Start;
+
+  Start = NowSeconds ();
+  for (Frame = 0; Frame < BENCH_FRAMES; Frame++) {
+    for (Row = 0; Row < BENCH_HEIGHT; Row++) {
+      Fill (mFrame + Row * BENCH_WIDTH, (UINT32)Frame, BENCH_WIDTH);
+    }
+  }
+  PrintRate (Name, Start);
+}
+
+/* Copy a whole frame row by row, like EfiBltBufferToVideo */
+STATIC
+VOID
+BenchCopy (
+  IN CONST char     *Name,
+  IN COPY_FUNCTION  Copy
+  )
+{
+  UINTN Frame;
+  UINTN Row;
+  double Start;
+
+  Start = NowSeconds ();
+  for (Frame = 0; Frame < BENCH_FRAMES; Frame++) {
+    for (Row = 0; Row < BENCH_HEIGHT; Row++) {
+      Copy (mFrame + Row * BENCH_WIDTH, mFrameSrc + Row * BENCH_WIDTH, BENCH_WIDTH);
+    }
+  }
+  PrintRate (Name, Start);
+}
+
+/* Move every row up by one, like scrolling the console without hardware help */
+STATIC
+VOID
+BenchScroll (
+  IN CONST char     *Name,
+  IN COPY_FUNCTION  Copy
+  )
+{
+  UINTN Frame;
+  UINTN Row;
+  double Start;
+
+  Start = NowSeconds ();
+  for (Frame = 0; Frame < BENCH_FRAMES; Frame++) {
+    for (Row = 0; Row < BENCH_HEIGHT - 1; Row++) {
+      Copy (mFrame + Row * BENCH_WIDTH, mFrame + (Row + 1) * BENCH_WIDTH, BENCH_WIDTH);
+    }
+  }
+  PrintRate (Name, Start);
+}
+
+int
+main (
+  VOID
+  )
+{
+  UINTN Index;
+
+  srand (1);
+  for (Index = 0; Index < sizeof (mNoise); Index++) {
+    mNoise[Index] = (UINT8)rand ();
+  }
+
+  TestFill ();
+  TestCopy ();
+  TestFill16 ();
+  TestCopy16 ();
+
+  printf ("%s: %lu checks, %lu failures\n",
+#if defined (MDE_CPU_AARCH64)
+          "NEON",
+#else
+          "Generic",
+#endif
+          (unsigned long)mChecks, (unsigned long)mFailures);
+
+  /* Touch every page before timing anything */
+  memset (mFrame, 0, sizeof (mFrame));
+  memset (mFrameSrc, 0x5A, sizeof (mFrameSrc));
+
+  printf ("Throughput over %d %dx%d frames:\n", BENCH_FRAMES, BENCH_WIDTH, BENCH_HEIGHT);
+  BenchFill ("DisplayBltFill", DisplayBltFill);
+  BenchFill ("DisplayBltFillGeneric", DisplayBltFillGeneric);
+  BenchCopy ("DisplayBltCopy", DisplayBltCopy);
+  BenchCopy ("DisplayBltCopyGeneric", DisplayBltCopyGeneric);
+  BenchScroll ("DisplayBltCopy (scroll)", DisplayBltCopy);
+  BenchScroll ("DisplayBltCopyGeneric (scroll)", DisplayBltCopyGeneric);
+
+  return mFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -16,6 +16,46 @@
 
 STATIC BOOLEAN mVop2Initialized = FALSE;
 STATIC HDMI_DISPLAY_TIMING *mCurrentTimings;
+STATIC HDMI_DISPLAY_TIMING mProgrammedTimings;
+STATIC UINT32 mLayerBytesPerPixel;
+
+/* ESMART scaler, as programmed by the Linux rockchip vop2 driver */
+#define VOP2_SCL_MODE_NONE          0
+#define VOP2_SCL_MODE_UP            1
+#define VOP2_SCL_FILTER_BILINEAR    1
+
+#define VOP2_SCL_CTRL_YRGB_HOR_MODE_SHIFT       0
+#define VOP2_SCL_CTRL_YRGB_HSCL_FILTER_SHIFT    2
+#define VOP2_SCL_CTRL_YRGB_VER_MODE_SHIFT       4
+#define VOP2_SCL_CTRL_YRGB_VSCL_FILTER_SHIFT    6
+
+/*
+ * Scale factor for upscaling Src pixels to Dst pixels, in 0.16 fixed point
+ * steps through the source per destination pixel.
+ */
+STATIC
+UINT32
+Vop2ScaleFactor (
+    IN UINT32 Src,
+    IN UINT32 Dst
+    )
+{
+    if (Src >= Dst || Src < 2) {
+        return 0;
+    }
+
+    return (((Src - 1) << 16) + (Dst - 2)) / (Dst - 1) - 1;
+}
+
+STATIC
+UINT32
+Vop2ScaleMode (
+    IN UINT32 Src,
+    IN UINT32 Dst
+    )
+{
+    return Src < Dst ? VOP2_SCL_MODE_UP : VOP2_SCL_MODE_NONE;
+}
 
 STATIC
 VOID
@@ -78,24 +118,28 @@ Vop2SetMode (
     UINT32 Val;
     UINT32 HSyncLen, HActSt, HActEnd, HBackPorch;
     UINT32 VSyncLen, VActSt, VActEnd, VBackPorch;
+    UINT32 SrcW, SrcH, DstW, DstH;
+    UINT32 DataFmt;
     UINTN Rate;
 
     mCurrentTimings = &mPreferredTimings;
 
     ASSERT (mCurrentTimings != NULL);
-    ASSERT (Mode->Info->HorizontalResolution == mCurrentTimings->HDisplay);
-    ASSERT (Mode->Info->VerticalResolution == mCurrentTimings->VDisplay);
+    ASSERT (Mode->Info->HorizontalResolution <= mCurrentTimings->HDisplay);
+    ASSERT (Mode->Info->VerticalResolution <= mCurrentTimings->VDisplay);
     ASSERT (Mode->FrameBufferBase != 0 && Mode->FrameBufferBase < SIZE_4GB);
 
     if (!mVop2Initialized) {
         Vop2Initialize ();
         mVop2Initialized = TRUE;
+    } else if (CompareMem (&mProgrammedTimings, mCurrentTimings, sizeof (mProgrammedTimings)) == 0) {
+        /* Same monitor timing, only the framebuffer and scaler change */
+        goto SetupLayer;
     }
 
+    /* Returns once the HPLL reports lock */
     CruSetHdmiClockRate (mCurrentTimings->FrequencyKHz * 1000);
 
-    gBS->Stall (100000); // XXX wait for lock
-
     Rate = CruGetHdmiClockRate ();
     DEBUG ((DEBUG_INFO, "Vop2SetMode(): HPLL rate %u Hz\n", Rate));
 
@@ -137,16 +181,44 @@ Vop2SetMode (
                      ~VOP2_DPn_BG_MIX_CTRL_DP_BG_DLY_NUM_MASK,
                      42 << VOP2_DPn_BG_MIX_CTRL_DP_BG_DLY_NUM_SHIFT);
 
-    /* Setup layer */
+    CopyMem (&mProgrammedTimings, mCurrentTimings, sizeof (mProgrammedTimings));
+
+SetupLayer:
+    /* Setup layer, scaling the framebuffer up to the full display if needed */
+    SrcW = Mode->Info->HorizontalResolution;
+    SrcH = Mode->Info->VerticalResolution;
+    DstW = mCurrentTimings->HDisplay;
+    DstH = mCurrentTimings->VDisplay;
+
+    /* RGB565 is the only PixelBitMask layout DisplayDxe hands out */
+    if (Mode->Info->PixelFormat == PixelBitMask) {
+        DataFmt = VOP2_ESMART_REGION0_MST_CTL_DATA_FMT_RGB565;
+        mLayerBytesPerPixel = 2;
+    } else {
+        DataFmt = VOP2_ESMART_REGION0_MST_CTL_DATA_FMT_ARGB8888;
+        mLayerBytesPerPixel = 4;
+    }
+
     MmioWrite32 (VOP2_ESMART_CTRL0 (0), BIT0);
-    MmioWrite32 (VOP2_ESMART_REGION0_VIR (0), Mode->Info->HorizontalResolution);
+    /* Stride is in 32-bit words */
+    MmioWrite32 (VOP2_ESMART_REGION0_VIR (0),
+                 Mode->Info->PixelsPerScanLine * mLayerBytesPerPixel / 4);
     MmioWrite32 (VOP2_ESMART_REGION0_MST_YRGB (0), (UINT32)Mode->FrameBufferBase);
-    MmioWrite32 (VOP2_ESMART_REGION0_ACT_INFO (0), ((mCurrentTimings->VDisplay - 1) << 16) | (mCurrentTimings->HDisplay - 1));
-    MmioWrite32 (VOP2_ESMART_REGION0_DSP_INFO (0), ((mCurrentTimings->VDisplay - 1) << 16) | (mCurrentTimings->HDisplay - 1));
+    MmioWrite32 (VOP2_ESMART_REGION0_ACT_INFO (0), ((SrcH - 1) << 16) | (SrcW - 1));
+    MmioWrite32 (VOP2_ESMART_REGION0_DSP_INFO (0), ((DstH - 1) << 16) | (DstW - 1));
     MmioWrite32 (VOP2_ESMART_REGION0_DSP_OFFSET (0), 0);
+    MmioWrite32 (VOP2_ESMART_REGION0_SCL_FACTOR_YRGB (0),
+                 (Vop2ScaleFactor (SrcH, DstH) << 16) | Vop2ScaleFactor (SrcW, DstW));
+    MmioWrite32 (VOP2_ESMART_REGION0_SCL_CTRL (0),
+                 (Vop2ScaleMode (SrcW, DstW) << VOP2_SCL_CTRL_YRGB_HOR_MODE_SHIFT) |
+                 (VOP2_SCL_FILTER_BILINEAR << VOP2_SCL_CTRL_YRGB_HSCL_FILTER_SHIFT) |
+                 (Vop2ScaleMode (SrcH, DstH) << VOP2_SCL_CTRL_YRGB_VER_MODE_SHIFT) |
+                 (VOP2_SCL_FILTER_BILINEAR << VOP2_SCL_CTRL_YRGB_VSCL_FILTER_SHIFT));
+    DEBUG ((DEBUG_INFO, "Vop2SetMode(): %ux%u framebuffer on %ux%u display\n",
+            SrcW, SrcH, DstW, DstH));
     MmioAndThenOr32 (VOP2_ESMART_REGION0_MST_CTL (0),
                      ~VOP2_ESMART_REGION0_MST_CTL_DATA_FMT_MASK,
-                     VOP2_ESMART_REGION0_MST_CTL_DATA_FMT_ARGB8888 | VOP2_ESMART_REGION0_MST_CTL_MST_ENABLE);
+                     DataFmt | VOP2_ESMART_REGION0_MST_CTL_MST_ENABLE);
 
     /* Set output mode and enable */
     Val = MmioRead32 (VOP2_POSTn_DSP_CTRL (0));
@@ -166,4 +238,65 @@ Vop2SetMode (
  
     /* Dump registers */
     Vop2DebugDump ();
+}
+
+/**
+  Stop scanout and put the video port in standby. The VOP finishes the
+  current frame first, so this waits one frame time before returning and
+  the clocks can be gated afterwards.
+
+  @return The DDR read bandwidth scanout was using, in bytes per second,
+          or 0 if no mode was set.
+
+**/
+UINT64
+Vop2Disable (
+    VOID
+    )
+{
+    UINT32 Val;
+    UINT64 FrameBytes;
+    UINT64 FramePixels;
+    UINT64 Bandwidth;
+
+    if (!mVop2Initialized) {
+        return 0;
+    }
+
+    /* ESMART0 fetches the framebuffer at ACT_INFO size once per frame */
+    Val = MmioRead32 (VOP2_ESMART_REGION0_ACT_INFO (0));
+    FrameBytes = (UINT64)((Val & 0xFFFF) + 1) * ((Val >> 16) + 1) * mLayerBytesPerPixel;
+    FramePixels = (UINT64)mProgrammedTimings.HTotal * mProgrammedTimings.VTotal;
+    Bandwidth = DivU64x64Remainder (MultU64x32 (FrameBytes, mProgrammedTimings.FrequencyKHz * 1000),
+                                    FramePixels, NULL);
+
+    MmioAnd32 (VOP2_ESMART_REGION0_MST_CTL (0), ~VOP2_ESMART_REGION0_MST_CTL_MST_ENABLE);
+    MmioOr32 (VOP2_POSTn_DSP_CTRL (0), VOP2_POSTn_DSP_CTRL_VOP_STANDBY_EN_IMD);
+    MmioAnd32 (VOP2_SYS_DSP_INFACE_EN, ~VOP2_SYS_DSP_INFACE_EN_HDMI_OUT_EN);
+    MmioWrite32 (VOP2_SYS_REG_CFG_DONE,
+                 VOP2_SYS_REG_CFG_DONE_SW_GLOBAL_REGDONE_EN |
+                 VOP2_SYS_REG_CFG_DONE_REG_LOAD_GLOBAL0_EN);
+
+    MicroSecondDelay ((UINTN)DivU64x32 (MultU64x32 (FramePixels, 1000),
+                                        mProgrammedTimings.FrequencyKHz) + 1);
+
+    /* Everything is reprogrammed on the next mode set */
+    mVop2Initialized = FALSE;
+    ZeroMem (&mProgrammedTimings, sizeof (mProgrammedTimings));
+
+    return Bandwidth;
+}
+
+VOID
+Vop2SetScanout (
+    IN EFI_PHYSICAL_ADDRESS Address
+    )
+{
+    ASSERT (Address != 0 && Address < SIZE_4GB);
+
+    /* Latched at the next frame start */
+    MmioWrite32 (VOP2_ESMART_REGION0_MST_YRGB (0), (UINT32)Address);
+    MmioWrite32 (VOP2_SYS_REG_CFG_DONE,
+                 VOP2_SYS_REG_CFG_DONE_SW_GLOBAL_REGDONE_EN |
+                 VOP2_SYS_REG_CFG_DONE_REG_LOAD_GLOBAL0_EN);
 }
\ No newline at end of file
@@ -14,4 +14,14 @@ Vop2SetMode (
   IN EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE *Mode
   );
 
+UINT64
+Vop2Disable (
+  VOID
+  );
+
+VOID
+Vop2SetScanout (
+  IN EFI_PHYSICAL_ADDRESS Address
+  );
+
 #endif /* _VOP2_H_ */
@@ -11,14 +11,71 @@
 #define __EMMC_H__
 
 #include <Protocol/EmbeddedGpio.h>
+#include <Rk356xConfigValues.h>
 
 #define SD_MMC_HC_CLOCK_CTRL    0x2C
 #define SD_MMC_HC_HOST_CTRL2    0x3E
 
+// SDHCI Registers
+#define EMMC_HC_BLK_SIZE        ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x004)
+#define EMMC_HC_BLK_COUNT       ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x006)
+#define EMMC_HC_ARG1            ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x008)
+#define EMMC_HC_TRANS_MOD       ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x00C)
+#define EMMC_HC_COMMAND         ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x00E)
+#define EMMC_HC_RESPONSE        ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x010)
+#define EMMC_HC_BUF_DAT_PORT    ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x020)
+#define EMMC_HC_PRESENT_STATE   ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x024)
+#define EMMC_HC_CLOCK_CTRL      ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + SD_MMC_HC_CLOCK_CTRL)
+#define EMMC_HC_SW_RST          ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x02F)
+#define EMMC_HC_NOR_INT_STS     ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x030)
+#define EMMC_HC_ERR_INT_STS     ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x032)
+#define EMMC_HC_HOST_CTRL2      ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + SD_MMC_HC_HOST_CTRL2)
+#define EMMC_HC_P_VENDOR_AREA2  ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x0EA)
+
+#define EMMC_HC_TRANS_MOD_READ             BIT4
+
+#define EMMC_HC_COMMAND_RESP_MASK          (BIT1|BIT0)
+#define EMMC_HC_COMMAND_RESP_NONE          (0 << 0)
+#define EMMC_HC_COMMAND_RESP_136           (1 << 0)
+#define EMMC_HC_COMMAND_RESP_48            (2 << 0)
+#define EMMC_HC_COMMAND_RESP_48_BUSY       (3 << 0)
+#define EMMC_HC_COMMAND_CRC_CHECK          BIT3
+#define EMMC_HC_COMMAND_INDEX_CHECK        BIT4
+#define EMMC_HC_COMMAND_DATA_PRESENT       BIT5
+#define EMMC_HC_COMMAND_INDEX(x)           ((x) << 8)
+
+#define EMMC_HC_PRESENT_STATE_CMD_INHIBIT  BIT0
+#define EMMC_HC_PRESENT_STATE_DAT_INHIBIT  BIT1
+
+#define EMMC_HC_CLOCK_CTRL_SD_CLK_EN       BIT2
+
+#define EMMC_HC_SW_RST_CMD                 BIT1
+#define EMMC_HC_SW_RST_DAT                 BIT2
+
+#define EMMC_HC_NOR_INT_STS_CMD_COMPLETE   BIT0
+#define EMMC_HC_NOR_INT_STS_XFER_COMPLETE  BIT1
+#define EMMC_HC_NOR_INT_STS_BUF_RD_READY   BIT5
+
+#define EMMC_HC_HOST_CTRL2_UHS_MASK        (BIT2|BIT1|BIT0)
+#define EMMC_HC_HOST_CTRL2_UHS_SDR104      (BIT1|BIT0)
+#define EMMC_HC_HOST_CTRL2_UHS_HS400       (BIT2|BIT1|BIT0)
+#define EMMC_HC_HOST_CTRL2_EXEC_TUNING     BIT6
+#define EMMC_HC_HOST_CTRL2_SAMPLING_CLK_SEL BIT7
+
+// Command Queue Host Controller registers, relative to EMMC_HC_P_VENDOR_AREA2
+#define CQHCI_CQVER                        0x00
+#define CQHCI_CQCFG                        0x08
+#define CQHCI_CQCTL                        0x0C
+
+#define CQHCI_CQCFG_ENABLE                 BIT0
+#define CQHCI_CQCTL_HALT                   BIT0
+
 // eMMC Registers
 #define SDMMC_BACKEND_POWER     ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x104)
 #define DWCMSHC_HOST_CTRL3      ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x508)
 #define EMMC_EMMC_CTRL          ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x52C)
+#define EMMC_AT_CTRL            ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x540)
+#define EMMC_AT_STAT            ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x544)
 #define EMMC_DLL_CTRL           ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x800)
 #define EMMC_DLL_RXCLK          ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x804)
 #define EMMC_DLL_TXCLK          ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x808)
@@ -26,6 +83,12 @@
 #define EMMC_DLL_STATUS0        ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x840)
 #define EMMC_DLL_STATUS1        ((UINT32)PcdGet32 (PcdEmmcDxeBaseAddress) + 0x844)
 
+#define EMMC_EMMC_CTRL_ENH_STROBE          BIT8
+
+#define EMMC_AT_CTRL_SW_TUNE_EN            BIT4
+
+#define EMMC_AT_STAT_CENTER_PH_CODE_MASK   0xFF
+
 #define EMMC_DLL_CTRL_SRST                 BIT0
 #define EMMC_DLL_CTRL_START                BIT1
 #define EMMC_DLL_CTRL_START_POINT_DEFAULT  (5 << 16)
@@ -40,8 +103,66 @@
 
 #define EMMC_DLL_STRBIN_DLYENA             BIT27
 #define EMMC_DLL_STRBIN_TAPNUM_DEFAULT     (0x3 << 0)
+#define EMMC_DLL_STRBIN_TAPNUM_ES          (0x8 << 0)
+#define EMMC_DLL_STRBIN_TAPNUM_FROM_SW     BIT24
+#define EMMC_DLL_STRBIN_DELAY_NUM_SEL      BIT26
+#define EMMC_DLL_STRBIN_DELAY_NUM_DEFAULT  (0x16 << 16)
 
 #define EMMC_DLL_STATUS0_DLL_LOCK          BIT8
 #define EMMC_DLL_STATUS0_DLL_TIMEOUT       BIT9
+#define EMMC_DLL_STATUS0_LOCK_VALUE_MASK   0xFF
+
+// eMMC commands and EXT_CSD fields used by the bus mode switches
+#define EMMC_CMD_SWITCH                    6
+#define EMMC_CMD_SELECT_DESELECT_CARD      7
+#define EMMC_CMD_SEND_EXT_CSD              8
+#define EMMC_CMD_SEND_CID                  10
+#define EMMC_CMD_SEND_STATUS               13
+#define EMMC_CMD_SEND_TUNING_BLOCK         21
+
+#define EMMC_TUNING_BLOCK_SIZE             128
+
+#define EMMC_SWITCH_ACCESS_WRITE_BYTE      3
+#define EMMC_SWITCH_ARG(Index, Value)      ((EMMC_SWITCH_ACCESS_WRITE_BYTE << 24) | \
+                                            ((Index) << 16) | ((Value) << 8))
+
+#define EMMC_CARD_STATUS_SWITCH_ERROR      BIT7
+
+#define EXT_CSD_SIZE                       512
+#define EXT_CSD_CMDQ_MODE_EN               15
+#define EXT_CSD_BUS_WIDTH                  183
+#define EXT_CSD_STROBE_SUPPORT             184
+#define EXT_CSD_HS_TIMING                  185
+#define EXT_CSD_DEVICE_TYPE                196
+#define EXT_CSD_CMDQ_DEPTH                 307
+#define EXT_CSD_CMDQ_SUPPORT               308
+
+#define EXT_CSD_BUS_WIDTH_8                2
+#define EXT_CSD_BUS_WIDTH_8_DDR            6
+#define EXT_CSD_BUS_WIDTH_STROBE           BIT7
+
+#define EXT_CSD_HS_TIMING_HS               1
+#define EXT_CSD_HS_TIMING_HS200            2
+#define EXT_CSD_HS_TIMING_HS400            3
+
+#define EXT_CSD_DEVICE_TYPE_HS200          (BIT4|BIT5)
+#define EXT_CSD_DEVICE_TYPE_HS400          (BIT6|BIT7)
+
+#define EXT_CSD_CMDQ_DEPTH_MASK            0x1F
+
+//
+// Bus tuning results kept across boots in the EmmcTuning variable.  The
+// cache only applies to the card whose CID matches and to the same clock.
+//
+#define EMMC_TUNING_CACHE_VARIABLE_NAME    L"EmmcTuning"
+
+typedef struct {
+  UINT32  Cid[4];
+  UINT32  ClockFreq;
+  UINT32  BusTiming;        // SD_MMC_BUS_MODE, SdMmcMmcHs200 or SdMmcMmcHs400
+  UINT8   DllLockValue;     // EMMC_DLL_STATUS0 lock value after the DLL start
+  UINT8   TuningPhase;      // EMMC_AT_STAT center phase after HS200 tuning
+  UINT8   Reserved[2];
+} EMMC_TUNING_CACHE;
 
 #endif  // __EMMC_H__
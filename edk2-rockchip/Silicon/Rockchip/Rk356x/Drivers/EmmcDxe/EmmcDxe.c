@@ -18,6 +18,7 @@
 #include <Library/TimerLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
 #include <Library/CruLib.h>
 #include <Library/GpioLib.h>
 
@@ -28,6 +29,21 @@
 
 #define EMMC_FORCE_HIGH_SPEED   FixedPcdGetBool(PcdEmmcForceHighSpeed)
 
+//
+// SdMmcPciHcDxe assigns each card a relative address of (Slot + 1)
+//
+#define EMMC_RCA(Slot)          ((UINT32)(Slot) + 1)
+
+#define EMMC_CMD_TIMEOUT_US     100000
+
+#define EMMC_TUNING_RETRIES     40
+
+//
+// Largest drift in the DLL lock value for which a cached tuning phase is
+// still tried.
+//
+#define EMMC_DLL_LOCK_TOLERANCE 2
+
 typedef struct {
   UINT32    TimeoutFreq   : 6; // bit 0:5
   UINT32    Reserved      : 1; // bit 6
@@ -79,6 +95,822 @@ STATIC CONST GPIO_IOMUX_CONFIG mEmmcIomuxConfig[] = {
 };
 
 STATIC EFI_HANDLE mSdMmcControllerHandle;
+STATIC UINT32     mBusModePolicy;
+STATIC UINT32     mHsClockFreq;
+STATIC BOOLEAN    mHostHs200;
+STATIC BOOLEAN    mHostHs400;
+STATIC BOOLEAN    mEnhancedStrobe;
+STATIC UINT8      mExtCsd[EXT_CSD_SIZE];
+
+STATIC UINT32            mCid[4];
+STATIC BOOLEAN           mCidValid;
+STATIC SD_MMC_BUS_MODE   mBusTiming;
+STATIC UINT32            mClockFreq;
+STATIC UINT8             mDllLockValue;
+STATIC EMMC_TUNING_CACHE mTuningCache;
+STATIC BOOLEAN           mTuningCacheValid;
+STATIC BOOLEAN           mTuningCacheHit;
+
+/**
+  Reset the CMD and DAT state machines after a failed command.
+
+**/
+STATIC
+VOID
+EmmcResetCmdDat (
+  VOID
+  )
+{
+  UINT32 Retry;
+
+  MmioWrite16 (EMMC_HC_ERR_INT_STS, 0xFFFF);
+  MmioWrite8 (EMMC_HC_SW_RST, EMMC_HC_SW_RST_CMD | EMMC_HC_SW_RST_DAT);
+  for (Retry = 0; Retry < EMMC_CMD_TIMEOUT_US; Retry++) {
+    if ((MmioRead8 (EMMC_HC_SW_RST) &
+         (EMMC_HC_SW_RST_CMD | EMMC_HC_SW_RST_DAT)) == 0) {
+      break;
+    }
+    gBS->Stall (1);
+  }
+}
+
+/**
+  Wait for all bits in Mask to be set in the normal interrupt status
+  register and acknowledge them.
+
+  @param[in]  Mask              Normal interrupt status bits to wait for.
+
+  @retval EFI_SUCCESS           All requested bits were set.
+  @retval EFI_DEVICE_ERROR      The controller flagged an error interrupt.
+  @retval EFI_TIMEOUT           The bits were not set in time.
+
+**/
+STATIC
+EFI_STATUS
+EmmcWaitIntStatus (
+  IN UINT16 Mask
+  )
+{
+  UINT16 ErrStatus;
+  UINT32 Retry;
+
+  for (Retry = 0; Retry < EMMC_CMD_TIMEOUT_US; Retry++) {
+    ErrStatus = MmioRead16 (EMMC_HC_ERR_INT_STS);
+    if (ErrStatus != 0) {
+      DEBUG ((DEBUG_ERROR, "EmmcWaitIntStatus: error status 0x%04X\n", ErrStatus));
+      return EFI_DEVICE_ERROR;
+    }
+    if ((MmioRead16 (EMMC_HC_NOR_INT_STS) & Mask) == Mask) {
+      MmioWrite16 (EMMC_HC_NOR_INT_STS, Mask);
+      return EFI_SUCCESS;
+    }
+    gBS->Stall (1);
+  }
+
+  return EFI_TIMEOUT;
+}
+
+/**
+  Issue a single command directly through the SDHCI registers.
+
+  SdMmcPciHcDxe only publishes its pass-thru protocol once the card is fully
+  initialized, so bus mode selection hooks have to talk to the card without it.
+  Data transfers are limited to a single block read in PIO mode.
+
+  @param[in]  Index             Command index.
+  @param[in]  Argument          Command argument.
+  @param[in]  Flags             EMMC_HC_COMMAND_* response and check flags.
+  @param[out] Response          Optional buffer for the response, four words
+                                for a 136-bit response.
+  @param[out] Buffer            Optional buffer for read data.
+  @param[in]  Length            Length of the read data in bytes.
+
+  @retval EFI_SUCCESS           The command completed successfully.
+  @retval Others                The command failed.
+
+**/
+STATIC
+EFI_STATUS
+EmmcSendCommand (
+  IN  UINT8   Index,
+  IN  UINT32  Argument,
+  IN  UINT16  Flags,
+  OUT UINT32  *Response OPTIONAL,
+  OUT UINT8   *Buffer OPTIONAL,
+  IN  UINT32  Length
+  )
+{
+  EFI_STATUS Status;
+  UINT32     Inhibit;
+  UINT32     Retry;
+  UINT32     Offset;
+  UINT32     Value;
+
+  Inhibit = EMMC_HC_PRESENT_STATE_CMD_INHIBIT;
+  if (Buffer != NULL ||
+      (Flags & EMMC_HC_COMMAND_RESP_48_BUSY) == EMMC_HC_COMMAND_RESP_48_BUSY) {
+    Inhibit |= EMMC_HC_PRESENT_STATE_DAT_INHIBIT;
+  }
+  for (Retry = 0; Retry < EMMC_CMD_TIMEOUT_US; Retry++) {
+    if ((MmioRead32 (EMMC_HC_PRESENT_STATE) & Inhibit) == 0) {
+      break;
+    }
+    gBS->Stall (1);
+  }
+  if (Retry == EMMC_CMD_TIMEOUT_US) {
+    return EFI_TIMEOUT;
+  }
+
+  if (Buffer != NULL) {
+    MmioWrite16 (EMMC_HC_BLK_SIZE, (UINT16)Length);
+    MmioWrite16 (EMMC_HC_BLK_COUNT, 1);
+    MmioWrite16 (EMMC_HC_TRANS_MOD, EMMC_HC_TRANS_MOD_READ);
+    Flags |= EMMC_HC_COMMAND_DATA_PRESENT;
+  } else {
+    MmioWrite16 (EMMC_HC_TRANS_MOD, 0);
+  }
+
+  MmioWrite32 (EMMC_HC_ARG1, Argument);
+  MmioWrite16 (EMMC_HC_COMMAND, EMMC_HC_COMMAND_INDEX (Index) | Flags);
+
+  Status = EmmcWaitIntStatus (EMMC_HC_NOR_INT_STS_CMD_COMPLETE);
+  if (EFI_ERROR (Status)) {
+    goto Error;
+  }
+
+  if (Response != NULL) {
+    Response[0] = MmioRead32 (EMMC_HC_RESPONSE);
+    if ((Flags & EMMC_HC_COMMAND_RESP_MASK) == EMMC_HC_COMMAND_RESP_136) {
+      Response[1] = MmioRead32 (EMMC_HC_RESPONSE + 0x4);
+      Response[2] = MmioRead32 (EMMC_HC_RESPONSE + 0x8);
+      Response[3] = MmioRead32 (EMMC_HC_RESPONSE + 0xC);
+    }
+  }
+
+  if (Buffer != NULL) {
+    Status = EmmcWaitIntStatus (EMMC_HC_NOR_INT_STS_BUF_RD_READY);
+    if (EFI_ERROR (Status)) {
+      goto Error;
+    }
+    for (Offset = 0; Offset < Length; Offset += sizeof (Value)) {
+      Value = MmioRead32 (EMMC_HC_BUF_DAT_PORT);
+      CopyMem (Buffer + Offset, &Value, sizeof (Value));
+    }
+  }
+
+  if ((Inhibit & EMMC_HC_PRESENT_STATE_DAT_INHIBIT) != 0) {
+    Status = EmmcWaitIntStatus (EMMC_HC_NOR_INT_STS_XFER_COMPLETE);
+    if (EFI_ERROR (Status)) {
+      goto Error;
+    }
+  }
+
+  return EFI_SUCCESS;
+
+Error:
+  DEBUG ((DEBUG_ERROR, "EmmcSendCommand: CMD%u failed: %r\n", Index, Status));
+  EmmcResetCmdDat ();
+  return Status;
+}
+
+/**
+  Check that the card did not flag a SWITCH_ERROR.
+
+  @param[in]  Slot              The 0 based slot index.
+
+**/
+STATIC
+EFI_STATUS
+EmmcCheckSwitchStatus (
+  IN UINT8 Slot
+  )
+{
+  EFI_STATUS Status;
+  UINT32     CardStatus;
+
+  Status = EmmcSendCommand (EMMC_CMD_SEND_STATUS, EMMC_RCA (Slot) << 16,
+             EMMC_HC_COMMAND_RESP_48 | EMMC_HC_COMMAND_CRC_CHECK |
+             EMMC_HC_COMMAND_INDEX_CHECK, &CardStatus, NULL, 0);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  if ((CardStatus & EMMC_CARD_STATUS_SWITCH_ERROR) != 0) {
+    DEBUG ((DEBUG_ERROR, "EmmcCheckSwitchStatus: switch error, status 0x%08X\n", CardStatus));
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Write an EXT_CSD byte with CMD6 (SWITCH).
+
+  @param[in]  Slot              The 0 based slot index.
+  @param[in]  Index             EXT_CSD byte offset.
+  @param[in]  Value             Value to write.
+  @param[in]  CheckStatus       Follow the switch with a CMD13 status check.
+                                Must be FALSE when the switch changes the bus
+                                timing and the host has not been updated yet.
+
+**/
+STATIC
+EFI_STATUS
+EmmcSwitch (
+  IN UINT8   Slot,
+  IN UINT8   Index,
+  IN UINT8   Value,
+  IN BOOLEAN CheckStatus
+  )
+{
+  EFI_STATUS Status;
+
+  Status = EmmcSendCommand (EMMC_CMD_SWITCH, EMMC_SWITCH_ARG (Index, Value),
+             EMMC_HC_COMMAND_RESP_48_BUSY | EMMC_HC_COMMAND_CRC_CHECK |
+             EMMC_HC_COMMAND_INDEX_CHECK, NULL, NULL, 0);
+  if (EFI_ERROR (Status) || !CheckStatus) {
+    return Status;
+  }
+
+  return EmmcCheckSwitchStatus (Slot);
+}
+
+/**
+  Read the CID register of the card.
+
+  CMD10 is only accepted in the stand-by state, so the card is deselected
+  for the duration of the read.
+
+  @param[in]  Slot              The 0 based slot index.
+  @param[out] Cid               The raw 136-bit response, without CRC.
+
+**/
+STATIC
+EFI_STATUS
+EmmcReadCid (
+  IN  UINT8  Slot,
+  OUT UINT32 *Cid
+  )
+{
+  EFI_STATUS Status;
+  EFI_STATUS SelectStatus;
+
+  Status = EmmcSendCommand (EMMC_CMD_SELECT_DESELECT_CARD, 0,
+             EMMC_HC_COMMAND_RESP_NONE, NULL, NULL, 0);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = EmmcSendCommand (EMMC_CMD_SEND_CID, EMMC_RCA (Slot) << 16,
+             EMMC_HC_COMMAND_RESP_136 | EMMC_HC_COMMAND_CRC_CHECK, Cid, NULL, 0);
+
+  SelectStatus = EmmcSendCommand (EMMC_CMD_SELECT_DESELECT_CARD,
+                   EMMC_RCA (Slot) << 16, EMMC_HC_COMMAND_RESP_48_BUSY |
+                   EMMC_HC_COMMAND_CRC_CHECK | EMMC_HC_COMMAND_INDEX_CHECK,
+                   NULL, NULL, 0);
+
+  return EFI_ERROR (Status) ? Status : SelectStatus;
+}
+
+/**
+  Read the tuning results saved by a previous boot, if any.
+
+**/
+STATIC
+VOID
+EmmcLoadTuningCache (
+  VOID
+  )
+{
+  EFI_STATUS Status;
+  UINTN      Size;
+
+  Size = sizeof (mTuningCache);
+  Status = gRT->GetVariable (EMMC_TUNING_CACHE_VARIABLE_NAME,
+                  &gRk356xTokenSpaceGuid, NULL, &Size, &mTuningCache);
+  mTuningCacheValid = !EFI_ERROR (Status) && Size == sizeof (mTuningCache);
+}
+
+/**
+  Forget the saved tuning results, so the next boot tunes from scratch.
+
+**/
+STATIC
+VOID
+EmmcDropTuningCache (
+  VOID
+  )
+{
+  EFI_STATUS Status;
+
+  mTuningCacheValid = FALSE;
+  Status = gRT->SetVariable (EMMC_TUNING_CACHE_VARIABLE_NAME,
+                  &gRk356xTokenSpaceGuid, 0, 0, NULL);
+  DEBUG ((DEBUG_INFO, "EmmcDropTuningCache: %r\n", Status));
+}
+
+/**
+  Check whether the cached tuning results apply to the current card.
+
+  @retval TRUE                  The CID, clock and bus mode all match.
+
+**/
+STATIC
+BOOLEAN
+EmmcTuningCacheMatches (
+  VOID
+  )
+{
+  if (!mTuningCacheValid || !mCidValid ||
+      CompareMem (mTuningCache.Cid, mCid, sizeof (mCid)) != 0 ||
+      mTuningCache.ClockFreq != mHsClockFreq) {
+    return FALSE;
+  }
+
+  switch (mTuningCache.BusTiming) {
+  case SdMmcMmcHs200:
+    return mHostHs200 &&
+           (mExtCsd[EXT_CSD_DEVICE_TYPE] & EXT_CSD_DEVICE_TYPE_HS200) != 0;
+  case SdMmcMmcHs400:
+    return mHostHs400 &&
+           (mExtCsd[EXT_CSD_DEVICE_TYPE] & EXT_CSD_DEVICE_TYPE_HS400) != 0;
+  default:
+    return FALSE;
+  }
+}
+
+/**
+  Save the tuning results of this boot so the next one can skip tuning.
+
+  Runs at ReadyToBoot, after the eMMC has been brought up. The variable is
+  only written when the results changed.
+
+  @param[in]  Event             The ReadyToBoot event.
+  @param[in]  Context           Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+EmmcSaveTuningCache (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EMMC_TUNING_CACHE Cache;
+  EFI_STATUS        Status;
+
+  gBS->CloseEvent (Event);
+
+  /* HS400ES needs no tuning, only HS200 and HS400 results are kept */
+  if (!mCidValid || mEnhancedStrobe ||
+      (mBusTiming != SdMmcMmcHs200 && mBusTiming != SdMmcMmcHs400)) {
+    return;
+  }
+
+  ZeroMem (&Cache, sizeof (Cache));
+  CopyMem (Cache.Cid, mCid, sizeof (Cache.Cid));
+  Cache.ClockFreq = mClockFreq;
+  Cache.BusTiming = mBusTiming;
+  Cache.DllLockValue = mDllLockValue;
+  Cache.TuningPhase = (UINT8)(MmioRead32 (EMMC_AT_STAT) &
+                              EMMC_AT_STAT_CENTER_PH_CODE_MASK);
+
+  if (mTuningCacheValid &&
+      CompareMem (&Cache, &mTuningCache, sizeof (Cache)) == 0) {
+    return;
+  }
+
+  Status = gRT->SetVariable (EMMC_TUNING_CACHE_VARIABLE_NAME,
+                  &gRk356xTokenSpaceGuid,
+                  EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                  sizeof (Cache), &Cache);
+  DEBUG ((DEBUG_INFO, "EmmcSaveTuningCache: phase %u, DLL lock %u: %r\n",
+    Cache.TuningPhase, Cache.DllLockValue, Status));
+}
+
+/**
+  Halt and disable the command queue engine, if the controller has one and
+  it was left enabled.
+
+  Neither this driver nor SdMmcPciHcDxe drive the CQE; it must be off while
+  legacy commands are issued and when the OS driver takes over the host.
+
+**/
+STATIC
+VOID
+EmmcDisableCqe (
+  VOID
+  )
+{
+  UINT32 Cqhci;
+  UINT32 Retry;
+
+  Cqhci = MmioRead16 (EMMC_HC_P_VENDOR_AREA2);
+  if (Cqhci == 0) {
+    return;
+  }
+  Cqhci += (UINT32)PcdGet32 (PcdEmmcDxeBaseAddress);
+
+  if ((MmioRead32 (Cqhci + CQHCI_CQCFG) & CQHCI_CQCFG_ENABLE) == 0) {
+    return;
+  }
+
+  MmioOr32 (Cqhci + CQHCI_CQCTL, CQHCI_CQCTL_HALT);
+  for (Retry = 0; Retry < EMMC_CMD_TIMEOUT_US; Retry++) {
+    if ((MmioRead32 (Cqhci + CQHCI_CQCTL) & CQHCI_CQCTL_HALT) != 0) {
+      break;
+    }
+    MicroSecondDelay (1);
+  }
+  MmioAnd32 (Cqhci + CQHCI_CQCFG, ~CQHCI_CQCFG_ENABLE);
+}
+
+/**
+  Hand the controller to the OS with the command queue engine disabled.
+
+  @param[in]  Event             The ExitBootServices event.
+  @param[in]  Context           Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+EmmcExitBootServices (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EmmcDisableCqe ();
+}
+
+/**
+  Program the DWCMSHC delay lines for the given card clock.
+
+  @param[in]  ClockFreq         The card clock frequency in Hz.
+
+**/
+STATIC
+VOID
+EmmcConfigureDll (
+  IN UINTN ClockFreq
+  )
+{
+  UINT32 Value, i;
+
+  if (ClockFreq <= 52000000UL) {
+    MmioWrite32 (EMMC_DLL_CTRL, 0);
+    MmioWrite32 (EMMC_DLL_RXCLK, BIT29);
+    MmioWrite32 (EMMC_DLL_TXCLK, 0);
+    if (mEnhancedStrobe) {
+      /*
+       * The strobe delay line must be configured before the card
+       * is switched to HS400ES.
+       */
+      MmioWrite32 (EMMC_DLL_STRBIN, EMMC_DLL_STRBIN_DLYENA |
+        EMMC_DLL_STRBIN_DELAY_NUM_SEL | EMMC_DLL_STRBIN_DELAY_NUM_DEFAULT);
+    } else {
+      MmioWrite32 (EMMC_DLL_STRBIN, 0);
+    }
+    return;
+  }
+
+  MmioWrite32(EMMC_DLL_CTRL, EMMC_DLL_CTRL_START);
+  gBS->Stall (1);
+  MmioWrite32(EMMC_DLL_CTRL, 0);
+
+  MmioWrite32(EMMC_DLL_CTRL, EMMC_DLL_CTRL_START_POINT_DEFAULT |
+    EMMC_DLL_CTRL_INCREMENT_DEFAULT | EMMC_DLL_CTRL_START);
+
+  for (i = 0; i < 500; i++) {
+    Value = MmioRead32(EMMC_DLL_STATUS0);
+    if (Value & EMMC_DLL_STATUS0_DLL_LOCK &&
+        !(Value & EMMC_DLL_STATUS0_DLL_TIMEOUT))
+      break;
+    gBS->Stall (1);
+  }
+  mDllLockValue = (UINT8)(Value & EMMC_DLL_STATUS0_LOCK_VALUE_MASK);
+
+  MmioWrite32(EMMC_DLL_RXCLK, EMMC_DLL_RXCLK_DLYENA |
+    EMMC_DLL_RXCLK_NO_INVERTER);
+  MmioWrite32(EMMC_DLL_TXCLK, EMMC_DLL_TXCLK_DLYENA |
+    EMMC_DLL_TXCLK_TAPNUM_DEFAULT | EMMC_DLL_TXCLK_TAPNUM_FROM_SW);
+  if (mEnhancedStrobe) {
+    MmioWrite32(EMMC_DLL_STRBIN, EMMC_DLL_STRBIN_DLYENA |
+      EMMC_DLL_STRBIN_TAPNUM_ES | EMMC_DLL_STRBIN_TAPNUM_FROM_SW);
+  } else {
+    MmioWrite32(EMMC_DLL_STRBIN, EMMC_DLL_TXCLK_DLYENA |
+      EMMC_DLL_STRBIN_TAPNUM_DEFAULT);
+  }
+}
+
+/**
+  Change the card clock outside of SdMmcPciHcDxe.
+
+  The divider register in this SDHCI controller does not work, so the card
+  clock is gated while the rate is changed at the CRU.
+
+  @param[in]  ClockFreq         The card clock frequency in Hz.
+
+**/
+STATIC
+VOID
+EmmcSetCardClock (
+  IN UINTN ClockFreq
+  )
+{
+  MmioAnd16 (EMMC_HC_CLOCK_CTRL, (UINT16)~EMMC_HC_CLOCK_CTRL_SD_CLK_EN);
+  CruSetEmmcClockRate (ClockFreq);
+  MmioOr16 (EMMC_HC_CLOCK_CTRL, EMMC_HC_CLOCK_CTRL_SD_CLK_EN);
+
+  EmmcConfigureDll (ClockFreq);
+}
+
+/**
+  Run the SDHCI tuning procedure with CMD21.
+
+  @retval EFI_SUCCESS           The host selected a sampling point.
+  @retval EFI_DEVICE_ERROR      Tuning did not converge.
+
+**/
+STATIC
+EFI_STATUS
+EmmcExecuteTuning (
+  VOID
+  )
+{
+  UINT16 HostCtrl2;
+  UINT32 Retry;
+
+  MmioAnd32 (EMMC_AT_CTRL, ~EMMC_AT_CTRL_SW_TUNE_EN);
+  MmioAndThenOr16 (EMMC_HC_HOST_CTRL2,
+    (UINT16)~EMMC_HC_HOST_CTRL2_SAMPLING_CLK_SEL,
+    EMMC_HC_HOST_CTRL2_EXEC_TUNING);
+
+  HostCtrl2 = 0;
+  for (Retry = 0; Retry < EMMC_TUNING_RETRIES; Retry++) {
+    /*
+     * While EXEC_TUNING is set the controller only raises Buffer Read
+     * Ready for each tuning block; the data need not be read out.
+     */
+    MmioWrite16 (EMMC_HC_BLK_SIZE, EMMC_TUNING_BLOCK_SIZE);
+    MmioWrite16 (EMMC_HC_BLK_COUNT, 1);
+    MmioWrite16 (EMMC_HC_TRANS_MOD, EMMC_HC_TRANS_MOD_READ);
+    MmioWrite32 (EMMC_HC_ARG1, 0);
+    MmioWrite16 (EMMC_HC_COMMAND,
+      EMMC_HC_COMMAND_INDEX (EMMC_CMD_SEND_TUNING_BLOCK) |
+      EMMC_HC_COMMAND_RESP_48 | EMMC_HC_COMMAND_CRC_CHECK |
+      EMMC_HC_COMMAND_INDEX_CHECK | EMMC_HC_COMMAND_DATA_PRESENT);
+    if (EFI_ERROR (EmmcWaitIntStatus (EMMC_HC_NOR_INT_STS_BUF_RD_READY))) {
+      break;
+    }
+
+    HostCtrl2 = MmioRead16 (EMMC_HC_HOST_CTRL2);
+    if ((HostCtrl2 & EMMC_HC_HOST_CTRL2_EXEC_TUNING) == 0) {
+      break;
+    }
+  }
+
+  if ((HostCtrl2 & (EMMC_HC_HOST_CTRL2_EXEC_TUNING |
+                    EMMC_HC_HOST_CTRL2_SAMPLING_CLK_SEL)) !=
+      EMMC_HC_HOST_CTRL2_SAMPLING_CLK_SEL) {
+    DEBUG ((DEBUG_ERROR, "EmmcExecuteTuning: tuning failed, HOST_CTRL2 0x%04X\n", HostCtrl2));
+    MmioAnd16 (EMMC_HC_HOST_CTRL2, (UINT16)~(EMMC_HC_HOST_CTRL2_EXEC_TUNING |
+                                             EMMC_HC_HOST_CTRL2_SAMPLING_CLK_SEL));
+    EmmcResetCmdDat ();
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Switch the card from HS (8-bit SDR, 52 MHz) to HS200.
+
+  The cached sampling phase is applied and checked with a single tuning
+  block read. A full tuning pass is only run when asked for, when the DLL
+  locked at a different value than last time or when the check fails.
+
+  @param[in]  Slot              The 0 based slot index.
+  @param[in]  FullTuning        Ignore the cached phase and tune.
+
+**/
+STATIC
+EFI_STATUS
+EmmcSwitchToHs200 (
+  IN UINT8   Slot,
+  IN BOOLEAN FullTuning
+  )
+{
+  EFI_STATUS Status;
+  UINT8      Block[EMMC_TUNING_BLOCK_SIZE];
+
+  Status = EmmcSwitch (Slot, EXT_CSD_HS_TIMING, EXT_CSD_HS_TIMING_HS200, FALSE);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  MmioAndThenOr16 (EMMC_HC_HOST_CTRL2, (UINT16)~EMMC_HC_HOST_CTRL2_UHS_MASK,
+    EMMC_HC_HOST_CTRL2_UHS_SDR104);
+  EmmcSetCardClock (mTuningCache.ClockFreq);
+
+  Status = EmmcCheckSwitchStatus (Slot);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (FullTuning) {
+    return EmmcExecuteTuning ();
+  }
+
+  if (ABS ((INTN)mDllLockValue - (INTN)mTuningCache.DllLockValue) >
+      EMMC_DLL_LOCK_TOLERANCE) {
+    DEBUG ((DEBUG_INFO, "EmmcSwitchToHs200: DLL lock %u, cached %u, retuning\n",
+      mDllLockValue, mTuningCache.DllLockValue));
+    return EmmcExecuteTuning ();
+  }
+
+  MmioOr32 (EMMC_AT_CTRL, EMMC_AT_CTRL_SW_TUNE_EN);
+  MmioAndThenOr32 (EMMC_AT_STAT, ~EMMC_AT_STAT_CENTER_PH_CODE_MASK,
+    mTuningCache.TuningPhase);
+  MmioOr16 (EMMC_HC_HOST_CTRL2, EMMC_HC_HOST_CTRL2_SAMPLING_CLK_SEL);
+
+  Status = EmmcSendCommand (EMMC_CMD_SEND_TUNING_BLOCK, 0,
+             EMMC_HC_COMMAND_RESP_48 | EMMC_HC_COMMAND_CRC_CHECK |
+             EMMC_HC_COMMAND_INDEX_CHECK, NULL, Block, sizeof (Block));
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "EmmcSwitchToHs200: cached phase %u failed, retuning\n",
+      mTuningCache.TuningPhase));
+    return EmmcExecuteTuning ();
+  }
+
+  DEBUG ((DEBUG_INFO, "EmmcSwitchToHs200: reusing tuning phase %u\n",
+    mTuningCache.TuningPhase));
+  return EFI_SUCCESS;
+}
+
+/**
+  Switch a tuned card from HS200 to HS400, following the same sequence as
+  SdMmcPciHcDxe: back to HS at 52 MHz, 8-bit DDR, then HS400 at full clock.
+
+  @param[in]  Slot              The 0 based slot index.
+
+**/
+STATIC
+EFI_STATUS
+EmmcSwitchHs200ToHs400 (
+  IN UINT8 Slot
+  )
+{
+  EFI_STATUS Status;
+
+  Status = EmmcSwitch (Slot, EXT_CSD_HS_TIMING, EXT_CSD_HS_TIMING_HS, FALSE);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  MmioAnd16 (EMMC_HC_HOST_CTRL2, (UINT16)~EMMC_HC_HOST_CTRL2_UHS_MASK);
+  EmmcSetCardClock (52000000UL);
+
+  Status = EmmcCheckSwitchStatus (Slot);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = EmmcSwitch (Slot, EXT_CSD_BUS_WIDTH, EXT_CSD_BUS_WIDTH_8_DDR, TRUE);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = EmmcSwitch (Slot, EXT_CSD_HS_TIMING, EXT_CSD_HS_TIMING_HS400, FALSE);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  MmioAndThenOr16 (EMMC_HC_HOST_CTRL2, (UINT16)~EMMC_HC_HOST_CTRL2_UHS_MASK,
+    EMMC_HC_HOST_CTRL2_UHS_HS400);
+  EmmcSetCardClock (mTuningCache.ClockFreq);
+
+  return EmmcCheckSwitchStatus (Slot);
+}
+
+/**
+  Switch the card from HS (8-bit SDR, 52 MHz) to HS400 with Enhanced Strobe.
+
+  With Enhanced Strobe the card drives the data strobe for both the CMD and
+  DAT lines, so no tuning is required in HS200 beforehand.
+
+  @param[in]  Slot              The 0 based slot index.
+
+**/
+STATIC
+EFI_STATUS
+EmmcSwitchToHs400Es (
+  IN UINT8 Slot
+  )
+{
+  EFI_STATUS Status;
+
+  Status = EmmcSwitch (Slot, EXT_CSD_BUS_WIDTH,
+             EXT_CSD_BUS_WIDTH_8_DDR | EXT_CSD_BUS_WIDTH_STROBE, TRUE);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = EmmcSwitch (Slot, EXT_CSD_HS_TIMING, EXT_CSD_HS_TIMING_HS400, FALSE);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  MmioAndThenOr16 (EMMC_HC_HOST_CTRL2, (UINT16)~EMMC_HC_HOST_CTRL2_UHS_MASK,
+    EMMC_HC_HOST_CTRL2_UHS_HS400);
+  MmioOr32 (EMMC_EMMC_CTRL, EMMC_EMMC_CTRL_ENH_STROBE);
+
+  EmmcSetCardClock (mHsClockFreq);
+
+  return EmmcCheckSwitchStatus (Slot);
+}
+
+/**
+  Take the card from HS to the bus mode recorded in the tuning cache.
+
+  @param[in]  Slot              The 0 based slot index.
+  @param[in]  FullTuning        Ignore the cached phase and tune.
+
+**/
+STATIC
+EFI_STATUS
+EmmcSwitchToCachedMode (
+  IN UINT8   Slot,
+  IN BOOLEAN FullTuning
+  )
+{
+  EFI_STATUS Status;
+
+  Status = EmmcSwitchToHs200 (Slot, FullTuning);
+  if (!EFI_ERROR (Status) && mTuningCache.BusTiming == SdMmcMmcHs400) {
+    Status = EmmcSwitchHs200ToHs400 (Slot);
+  }
+  return Status;
+}
+
+/**
+  Return host and card to 8-bit HS at 52 MHz after a failed bus mode switch.
+
+  @param[in]  Slot              The 0 based slot index.
+
+**/
+STATIC
+VOID
+EmmcRestoreHighSpeed (
+  IN UINT8 Slot
+  )
+{
+  mEnhancedStrobe = FALSE;
+  mTuningCacheHit = FALSE;
+
+  MmioAnd32 (EMMC_EMMC_CTRL, ~EMMC_EMMC_CTRL_ENH_STROBE);
+  MmioAnd32 (EMMC_AT_CTRL, ~EMMC_AT_CTRL_SW_TUNE_EN);
+  MmioAnd16 (EMMC_HC_HOST_CTRL2, (UINT16)~(EMMC_HC_HOST_CTRL2_UHS_MASK |
+                                           EMMC_HC_HOST_CTRL2_SAMPLING_CLK_SEL));
+  EmmcSetCardClock (52000000UL);
+
+  EmmcSwitch (Slot, EXT_CSD_HS_TIMING, EXT_CSD_HS_TIMING_HS, FALSE);
+  EmmcSwitch (Slot, EXT_CSD_BUS_WIDTH, EXT_CSD_BUS_WIDTH_8, TRUE);
+}
+
+/**
+  Publish the negotiated bus mode and clock for the setup menu.
+
+**/
+STATIC
+VOID
+EmmcReportBusMode (
+  VOID
+  )
+{
+  UINT32 Mode;
+
+  switch (mBusTiming) {
+  case SdMmcMmcHs400:
+    Mode = mEnhancedStrobe ? EMMC_STATUS_MODE_HS400ES : EMMC_STATUS_MODE_HS400;
+    break;
+  case SdMmcMmcHs200:
+    Mode = EMMC_STATUS_MODE_HS200;
+    break;
+  case SdMmcMmcHsDdr:
+    Mode = EMMC_STATUS_MODE_DDR52;
+    break;
+  case SdMmcMmcHsSdr:
+    Mode = EMMC_STATUS_MODE_HS52;
+    break;
+  default:
+    Mode = EMMC_STATUS_MODE_LEGACY;
+    break;
+  }
+
+  PcdSet32S (PcdEmmcCurrentBusMode, Mode);
+  PcdSet32S (PcdEmmcCurrentClock, mClockFreq / 1000000UL);
+}
 
 /**
   Override function for SDHCI capability bits
@@ -113,14 +945,48 @@ EmmcSdMmcCapability (
     return EFI_NOT_FOUND;
   }
 
-  if (EMMC_FORCE_HIGH_SPEED) {
+  /*
+   * PcdEmmcForceHighSpeed is a board limit and overrides the setup
+   * policy. HS200 and HS400 run at the clock selected in setup, which
+   * the CRU can provide at 100, 150 or 200 MHz.
+   */
+  mBusModePolicy = EMMC_FORCE_HIGH_SPEED ? EMMC_BUS_MODE_HS52 :
+                                           PcdGet32 (PcdEmmcBusMode);
+  mHsClockFreq = PcdGet32 (PcdEmmcClock) * 1000000UL;
+  if (mHsClockFreq < 100000000UL || mHsClockFreq > 200000000UL) {
+    mHsClockFreq = 200000000UL;
+  }
+
+  if (mBusModePolicy == EMMC_BUS_MODE_HS52) {
     Capability->BaseClkFreq = 52;
     Capability->Sdr50 = 0;
     Capability->Ddr50 = 0;
     Capability->Sdr104 = 0;
     Capability->Hs400 = 0;
+  } else if (mBusModePolicy == EMMC_BUS_MODE_HS200) {
+    Capability->Hs400 = 0;
   }
 
+  /*
+   * The DWCMSHC is a v4.10 host with 64-bit system addressing. Advertising
+   * it makes SdMmcPciHcDxe program 64-bit DMA addresses and enable dual
+   * address cycle on the non-discoverable PCI I/O, so buffers above 4 GiB
+   * are not bounced.
+   *
+   * The controller cannot DMA across a 128 MiB boundary (Linux splits
+   * ADMA2 descriptors in dwcmshc_adma_write_desc). SdMmcPciHcDxe builds
+   * ADMA2 tables by length only, with 26-bit lengths on a v4.10 host, and
+   * the override protocol has no hook into them. Use SDMA instead: it
+   * stops at every 512 KiB buffer boundary, which never straddles 128 MiB.
+   */
+  Capability->Adma2 = 0;
+  Capability->Sdma = 1;
+  Capability->SysBus64V3 = 1;
+  Capability->SysBus64V4 = 1;
+
+  mHostHs200 = Capability->Sdr104 != 0;
+  mHostHs400 = Capability->Hs400 != 0;
+
   return EFI_SUCCESS;
 }
 
@@ -150,9 +1016,10 @@ EmmcSdMmcNotifyPhase (
   IN OUT  VOID                           *PhaseData
   )
 {
-  SD_MMC_BUS_MODE                 *Timing;
-  UINTN                            MaxClockFreq;
-  UINT32                           Value, i;
+  SD_MMC_BUS_MODE                    *Timing;
+  EDKII_SD_MMC_OPERATING_PARAMETERS  *OperatingParameters;
+  UINTN                              MaxClockFreq;
+  EFI_STATUS                         Status;
 
   DEBUG ((DEBUG_INFO, "EmmcSdMmcNotifyPhase()\n"));
 
@@ -202,7 +1069,7 @@ EmmcSdMmcNotifyPhase (
     switch (*Timing) {
     case SdMmcMmcHs400:
     case SdMmcMmcHs200:
-      MaxClockFreq = 200000000UL;
+      MaxClockFreq = mHsClockFreq;
       break;
     case SdMmcMmcHsSdr:
     case SdMmcMmcHsDdr:
@@ -214,36 +1081,110 @@ EmmcSdMmcNotifyPhase (
     }
 
     CruSetEmmcClockRate(MaxClockFreq);
+    EmmcConfigureDll (MaxClockFreq);
 
-    if (MaxClockFreq <= 52000000UL) {
-      MmioWrite32 (EMMC_DLL_CTRL, 0);
-      MmioWrite32 (EMMC_DLL_RXCLK, BIT29);
-      MmioWrite32 (EMMC_DLL_TXCLK, 0);
-      MmioWrite32 (EMMC_DLL_STRBIN, 0);
+    mBusTiming = *Timing;
+    mClockFreq = MaxClockFreq;
+
+    if (*Timing == SdMmcMmcHsSdr && mEnhancedStrobe) {
+      Status = EmmcSwitchToHs400Es (Slot);
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_WARN, "EmmcSdMmcNotifyPhase: HS400ES switch failed (%r), staying in HS\n", Status));
+        EmmcRestoreHighSpeed (Slot);
+      } else {
+        DEBUG ((DEBUG_INFO, "EmmcSdMmcNotifyPhase: HS400ES enabled\n"));
+        mBusTiming = SdMmcMmcHs400;
+        mClockFreq = mHsClockFreq;
+      }
+    } else if (*Timing == SdMmcMmcHsSdr && mTuningCacheHit) {
+      Status = EmmcSwitchToCachedMode (Slot, FALSE);
+      if (EFI_ERROR (Status)) {
+        /*
+         * Don't let a stale cache pin the card at HS on every boot: drop
+         * it, and try once more with a full tuning pass from HS.
+         */
+        DEBUG ((DEBUG_WARN, "EmmcSdMmcNotifyPhase: cached bus mode switch failed (%r), retuning\n", Status));
+        EmmcDropTuningCache ();
+        EmmcRestoreHighSpeed (Slot);
+        Status = EmmcSwitchToCachedMode (Slot, TRUE);
+      }
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_WARN, "EmmcSdMmcNotifyPhase: bus mode switch failed (%r), staying in HS\n", Status));
+        EmmcRestoreHighSpeed (Slot);
+      } else {
+        mBusTiming = (SD_MMC_BUS_MODE)mTuningCache.BusTiming;
+        mClockFreq = mTuningCache.ClockFreq;
+      }
+    }
+
+    EmmcReportBusMode ();
+    break;
+
+  case EdkiiSdMmcGetOperatingParam:
+    if (PhaseData == NULL) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    OperatingParameters = (EDKII_SD_MMC_OPERATING_PARAMETERS *)PhaseData;
+
+    mEnhancedStrobe = FALSE;
+    mTuningCacheHit = FALSE;
+    if (mBusModePolicy == EMMC_BUS_MODE_HS52 || (!mHostHs200 && !mHostHs400)) {
       break;
     }
 
-    MmioWrite32(EMMC_DLL_CTRL, EMMC_DLL_CTRL_START);
-    gBS->Stall (1);
-    MmioWrite32(EMMC_DLL_CTRL, 0);
+    Status = EmmcSendCommand (EMMC_CMD_SEND_EXT_CSD, 0,
+               EMMC_HC_COMMAND_RESP_48 | EMMC_HC_COMMAND_CRC_CHECK |
+               EMMC_HC_COMMAND_INDEX_CHECK, NULL, mExtCsd, EXT_CSD_SIZE);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "EmmcSdMmcNotifyPhase: cannot read EXT_CSD: %r\n", Status));
+      break;
+    }
+
+    /*
+     * Data transfers are issued as legacy commands, which the card
+     * rejects while command queuing is enabled.
+     */
+    if ((mExtCsd[EXT_CSD_CMDQ_SUPPORT] & BIT0) != 0) {
+      DEBUG ((DEBUG_INFO, "EmmcSdMmcNotifyPhase: card supports command queuing, depth %u\n",
+        (mExtCsd[EXT_CSD_CMDQ_DEPTH] & EXT_CSD_CMDQ_DEPTH_MASK) + 1));
+      if ((mExtCsd[EXT_CSD_CMDQ_MODE_EN] & BIT0) != 0) {
+        Status = EmmcSwitch (Slot, EXT_CSD_CMDQ_MODE_EN, 0, TRUE);
+        DEBUG ((DEBUG_INFO, "EmmcSdMmcNotifyPhase: disable command queuing: %r\n", Status));
+      }
+    }
 
-    MmioWrite32(EMMC_DLL_CTRL, EMMC_DLL_CTRL_START_POINT_DEFAULT |
-      EMMC_DLL_CTRL_INCREMENT_DEFAULT | EMMC_DLL_CTRL_START);
+    mCidValid = !EFI_ERROR (EmmcReadCid (Slot, mCid));
+    EmmcLoadTuningCache ();
 
-    for (i = 0; i < 500; i++) {
-      Value = MmioRead32(EMMC_DLL_STATUS0);
-      if (Value & EMMC_DLL_STATUS0_DLL_LOCK &&
-          !(Value & EMMC_DLL_STATUS0_DLL_TIMEOUT))
-        break;
-      gBS->Stall (1);
+    /*
+     * Enhanced Strobe skips HS200 tuning entirely. Ask SdMmcPciHcDxe for
+     * 8-bit HS at 52 MHz and take the card to HS400ES from there once the
+     * clock switch is posted.
+     */
+    if ((mBusModePolicy == EMMC_BUS_MODE_AUTO ||
+         mBusModePolicy == EMMC_BUS_MODE_HS400ES) && mHostHs400 &&
+        (mExtCsd[EXT_CSD_DEVICE_TYPE] & EXT_CSD_DEVICE_TYPE_HS400) != 0 &&
+        (mExtCsd[EXT_CSD_STROBE_SUPPORT] & BIT0) != 0) {
+      mEnhancedStrobe = TRUE;
+      OperatingParameters->BusTiming = SdMmcMmcHsSdr;
+      OperatingParameters->BusWidth = 8;
+      OperatingParameters->ClockFreq = 52;
+      break;
     }
 
-    MmioWrite32(EMMC_DLL_RXCLK, EMMC_DLL_RXCLK_DLYENA |
-      EMMC_DLL_RXCLK_NO_INVERTER);
-    MmioWrite32(EMMC_DLL_TXCLK, EMMC_DLL_TXCLK_DLYENA |
-      EMMC_DLL_TXCLK_TAPNUM_DEFAULT | EMMC_DLL_TXCLK_TAPNUM_FROM_SW);
-    MmioWrite32(EMMC_DLL_STRBIN, EMMC_DLL_TXCLK_DLYENA |
-      EMMC_DLL_STRBIN_TAPNUM_DEFAULT);
+    /*
+     * If a previous boot tuned this card, start from the same HS launch
+     * pad and switch to HS200/HS400 here, reusing the saved sampling
+     * phase. Otherwise leave the choice and the tuning to the generic
+     * driver; the results are saved at ReadyToBoot.
+     */
+    if (EmmcTuningCacheMatches ()) {
+      mTuningCacheHit = TRUE;
+      OperatingParameters->BusTiming = SdMmcMmcHsSdr;
+      OperatingParameters->BusWidth = 8;
+      OperatingParameters->ClockFreq = 52;
+    }
     break;
 
   default:
@@ -267,6 +1208,7 @@ EmmcDxeInitialize (
 {
   EFI_STATUS                      Status;
   EFI_HANDLE                      Handle;
+  EFI_EVENT                       Event;
 
   /* Start card on 375 kHz */
   CruSetEmmcClockRate (375000UL);
@@ -282,6 +1224,9 @@ EmmcDxeInitialize (
   /* Switch to eMMC mode */
   MmioOr32 (EMMC_EMMC_CTRL, BIT0);
 
+  /* A previous boot stage may have left the command queue engine running */
+  EmmcDisableCqe ();
+
   /* Disable DLL for identification */
   MmioWrite32 (EMMC_DLL_CTRL, 0);
   MmioWrite32 (EMMC_DLL_RXCLK, BIT29);
@@ -303,5 +1248,13 @@ EmmcDxeInitialize (
                   EFI_NATIVE_INTERFACE, (VOID **)&mSdMmcOverride);
   ASSERT_EFI_ERROR (Status);
 
+  Status = EfiCreateEventReadyToBootEx (TPL_CALLBACK, EmmcSaveTuningCache,
+             NULL, &Event);
+  ASSERT_EFI_ERROR (Status);
+
+  Status = gBS->CreateEvent (EVT_SIGNAL_EXIT_BOOT_SERVICES, TPL_NOTIFY,
+                  EmmcExitBootServices, NULL, &Event);
+  ASSERT_EFI_ERROR (Status);
+
   return EFI_SUCCESS;
 }
@@ -10,6 +10,7 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/IoLib.h>
+#include <Library/MultiPhyLib.h>
 #include <Library/TimerLib.h>
 #include <Library/NonDiscoverableDeviceRegistrationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
@@ -22,6 +23,8 @@
 
 #define SATA_CAP            0x0000
 #define  SATA_CAP_SSS       BIT27
+#define  SATA_CAP_SPM       BIT17
+#define  SATA_CAP_FBSS      BIT16
 #define SATA_GHC            0x0004
 #define  SATA_GHC_AE        BIT31
 #define  SATA_GHC_IE        BIT1
@@ -30,6 +33,156 @@
 #define SATA_PIS            0x0110
 #define SATA_CMD            0x0118
 #define  SATA_CMD_FBSCP     BIT22
+#define  SATA_CMD_SUD       BIT1
+#define SATA_SSTS           0x0128
+#define  SATA_SSTS_DET_MASK 0xF
+#define  SATA_SSTS_DET_NONE 0x0
+#define  SATA_SSTS_DET_PHY  0x3
+#define  SATA_SSTS_SPD_SHIFT 4
+#define  SATA_SSTS_SPD_MASK (0xFU << SATA_SSTS_SPD_SHIFT)
+#define  SATA_SSTS_SPD_GEN3 3
+#define SATA_SCTL           0x012C
+#define  SATA_SCTL_DET_MASK 0xF
+#define  SATA_SCTL_DET_INIT 0x1
+#define SATA_SERR           0x0130
+#define  SATA_SERR_DIAG_H   BIT22   /* Handshake error */
+#define  SATA_SERR_DIAG_C   BIT21   /* CRC error */
+#define  SATA_SERR_DIAG_D   BIT20   /* Disparity error */
+#define  SATA_SERR_DIAG_B   BIT19   /* 10B to 8B decode error */
+#define  SATA_SERR_ERR_C    BIT10   /* Persistent communication error */
+#define  SATA_SERR_ERR_T    BIT9    /* Transient data integrity error */
+#define  SATA_SERR_LINK_ERRORS  (SATA_SERR_DIAG_H | SATA_SERR_DIAG_C | \
+                                 SATA_SERR_DIAG_D | SATA_SERR_DIAG_B | \
+                                 SATA_SERR_ERR_C | SATA_SERR_ERR_T)
+
+/* AHCI gives the HBA up to one second to complete a reset */
+#define SATA_RESET_TIMEOUT_US   1000000
+#define SATA_LINK_TIMEOUT_US    100000
+/* A device answers COMRESET with COMINIT within 10 ms, or the port is empty */
+#define SATA_DETECT_TIMEOUT_US  10000
+/* How long an idle link is watched for errors once the PHY is ready */
+#define SATA_SETTLE_US          10000
+
+STATIC
+BOOLEAN
+IsSataControllerEnabled (
+    IN  UINTN   Index
+    )
+{
+    return !((Index == 0 && FixedPcdGet8(PcdSata0Status) == 0x0) ||
+             (Index == 1 && FixedPcdGet8(PcdSata1Status) == 0x0) ||
+             (Index == 2 && FixedPcdGet8(PcdSata2Status) == 0x0));
+}
+
+STATIC
+VOID
+SataComReset (
+    IN  EFI_PHYSICAL_ADDRESS    SataBase
+    )
+{
+    MmioAndThenOr32 (SataBase + SATA_SCTL, ~SATA_SCTL_DET_MASK, SATA_SCTL_DET_INIT);
+    MicroSecondDelay (1000);
+    MmioAnd32 (SataBase + SATA_SCTL, ~SATA_SCTL_DET_MASK);
+}
+
+/*
+ * Returns the negotiated generation (1-3) after the link settles, or 0
+ * without a link. Reports the SError bits seen while it settled.
+ */
+STATIC
+UINT32
+SataGetLinkSpeed (
+    IN  EFI_PHYSICAL_ADDRESS    SataBase,
+    OUT UINT32                  *Errors
+    )
+{
+    UINT32 SStatus;
+    UINTN Retry;
+
+    for (Retry = 0; Retry < SATA_LINK_TIMEOUT_US; Retry += 100) {
+        SStatus = MmioRead32 (SataBase + SATA_SSTS);
+        if ((SStatus & SATA_SSTS_DET_MASK) == SATA_SSTS_DET_PHY) {
+            break;
+        }
+        if ((SStatus & SATA_SSTS_DET_MASK) == SATA_SSTS_DET_NONE &&
+            Retry >= SATA_DETECT_TIMEOUT_US) {
+            break;
+        }
+        MicroSecondDelay (100);
+    }
+
+    /*
+     * OOB signalling and speed negotiation leave handshake and decode
+     * errors behind on a healthy link. Clear them once the PHY is ready
+     * and only report what the link picks up after that.
+     */
+    MmioWrite32 (SataBase + SATA_SERR, MAX_UINT32);
+    *Errors = 0;
+    if ((SStatus & SATA_SSTS_DET_MASK) != SATA_SSTS_DET_PHY) {
+        return 0;
+    }
+
+    MicroSecondDelay (SATA_SETTLE_US);
+    *Errors = MmioRead32 (SataBase + SATA_SERR);
+    MmioWrite32 (SataBase + SATA_SERR, *Errors);
+
+    SStatus = MmioRead32 (SataBase + SATA_SSTS);
+    if ((SStatus & SATA_SSTS_DET_MASK) != SATA_SSTS_DET_PHY) {
+        return 0;
+    }
+    return (SStatus & SATA_SSTS_SPD_MASK) >> SATA_SSTS_SPD_SHIFT;
+}
+
+/*
+ * A link that came up below 6 Gb/s or with errors is retried with the
+ * alternate PHY tunings. The best one found is kept.
+ */
+STATIC
+VOID
+SataTuneLink (
+    IN  UINT8                   Index,
+    IN  EFI_PHYSICAL_ADDRESS    SataBase
+    )
+{
+    UINT32 Speed, BestSpeed;
+    UINT32 Errors, BestErrors;
+    UINT8 Tuning, BestTuning;
+
+    BestTuning = 0;
+    BestSpeed = SataGetLinkSpeed (SataBase, &BestErrors);
+    if (BestSpeed == 0) {
+        DEBUG ((DEBUG_INFO, "SATA%u: No link\n", Index));
+        return;
+    }
+
+    for (Tuning = 1;
+         (BestSpeed < SATA_SSTS_SPD_GEN3 || (BestErrors & SATA_SERR_LINK_ERRORS) != 0) &&
+         !EFI_ERROR (MultiPhySetSataTuning (Index, Tuning));
+         Tuning++) {
+        SataComReset (SataBase);
+        Speed = SataGetLinkSpeed (SataBase, &Errors);
+        DEBUG ((DEBUG_INFO, "SATA%u: PHY tuning %u: Gen%u, SERR 0x%08X\n",
+                Index, Tuning, Speed, Errors));
+        if (Speed > BestSpeed ||
+            (Speed == BestSpeed && (Errors & SATA_SERR_LINK_ERRORS) == 0 &&
+             (BestErrors & SATA_SERR_LINK_ERRORS) != 0)) {
+            BestTuning = Tuning;
+            BestSpeed = Speed;
+            BestErrors = Errors;
+        }
+    }
+
+    if (Tuning > 1 && BestTuning != Tuning - 1) {
+        MultiPhySetSataTuning (Index, BestTuning);
+        SataComReset (SataBase);
+        BestSpeed = SataGetLinkSpeed (SataBase, &BestErrors);
+    }
+
+    DEBUG ((DEBUG_INFO, "SATA%u: Link up at %a Gb/s, PHY tuning %u, SERR 0x%08X\n",
+            Index,
+            BestSpeed == 3 ? "6.0" : BestSpeed == 2 ? "3.0" : "1.5",
+            BestTuning, BestErrors));
+}
 
 EFIAPI
 EFI_STATUS
@@ -37,24 +190,43 @@ InitializeSataController (
     IN  EFI_PHYSICAL_ADDRESS    SataBase
     )
 {
+    UINTN Retry;
+
     /* Set port implemented flag */
     MmioWrite32 (SataBase + SATA_PI, 0x1);
     /* Supports staggered spin-up */
     MmioOr32 (SataBase + SATA_CAP, SATA_CAP_SSS);
-    /* Supports FIS-based switching */
+    /*
+     * Supports port multipliers with FIS-based switching. FBSCP alone is
+     * ignored by OS drivers unless the HBA also reports SPM and FBSS.
+     */
+    MmioOr32 (SataBase + SATA_CAP, SATA_CAP_SPM | SATA_CAP_FBSS);
     MmioOr32 (SataBase + SATA_CMD, SATA_CMD_FBSCP);
 
     /* Reset controller */
     MmioOr32 (SataBase + SATA_GHC, SATA_GHC_HR);
-    while ((MmioRead32 (SataBase + SATA_GHC) & SATA_GHC_HR) != 0) {
-        DEBUG ((DEBUG_INFO, "SATA: Waiting for reset ...\n"));
-        gBS->Stall (10000);
+    for (Retry = 0; Retry < SATA_RESET_TIMEOUT_US; Retry++) {
+        if ((MmioRead32 (SataBase + SATA_GHC) & SATA_GHC_HR) == 0) {
+            break;
+        }
+        MicroSecondDelay (1);
+    }
+    if (Retry == SATA_RESET_TIMEOUT_US) {
+        DEBUG ((DEBUG_ERROR, "SATA: Controller at 0x%08X did not come out of reset\n", SataBase));
+        return EFI_TIMEOUT;
     }
     MmioWrite32 (SataBase + SATA_PIS, 0xFFFFFFFF);
 
     /* Enable controller */
     MmioOr32 (SataBase + SATA_GHC, SATA_GHC_AE);
 
+    /*
+     * With staggered spin-up the HBA reset leaves the port idle. Spinning
+     * it up sends the COMRESET, so link negotiation and disk spin-up run
+     * in the background while the rest of DXE is dispatched.
+     */
+    MmioOr32 (SataBase + SATA_CMD, SATA_CMD_SUD);
+
     return EFI_SUCCESS;
 }
 
@@ -75,15 +247,24 @@ SataEndOfDxeCallback (
          Index < NumSataController;
          Index++, SataBase += PcdGet64 (PcdSataSize)) {
 
-        if ((Index == 0 && FixedPcdGet8(PcdSata0Status) == 0x0) ||
-            (Index == 1 && FixedPcdGet8(PcdSata1Status) == 0x0) ||
-            (Index == 2 && FixedPcdGet8(PcdSata2Status) == 0x0)) {
+        if (!IsSataControllerEnabled (Index)) {
             continue;
         }
 
-        DEBUG ((DEBUG_INFO, "SATA: Registering SATA controller at 0x%08X\n", SataBase));
+        /*
+         * The controller was started at driver entry. If there is no link
+         * yet, the PHY may only have been switched to SATA mode since then,
+         * so send another COMRESET before handing the port to the AHCI
+         * driver.
+         */
+        if ((MmioRead32 (SataBase + SATA_SSTS) & SATA_SSTS_DET_MASK) != SATA_SSTS_DET_PHY) {
+            SataComReset (SataBase);
+        }
 
-        InitializeSataController (SataBase);
+        SataTuneLink ((UINT8)Index, SataBase);
+
+        DEBUG ((DEBUG_INFO, "SATA: Registering SATA controller at 0x%08X, SSTS 0x%08X\n",
+                SataBase, MmioRead32 (SataBase + SATA_SSTS)));
 
         Status = RegisterNonDiscoverableMmioDevice (
                 NonDiscoverableDeviceTypeAhci,
@@ -105,6 +286,23 @@ InitializeSata (
 {
     EFI_STATUS Status;
     EFI_EVENT EndOfDxeEvent;
+    EFI_PHYSICAL_ADDRESS SataBase;
+    UINTN Index;
+    UINT32 NumSataController = PcdGet32 (PcdSataNumController);
+
+    /* Start link negotiation early, registration is done at EndOfDxe */
+    for (Index = 0, SataBase = SATA_BASE;
+         Index < NumSataController;
+         Index++, SataBase += PcdGet64 (PcdSataSize)) {
+
+        if (!IsSataControllerEnabled (Index)) {
+            continue;
+        }
+
+        DEBUG ((DEBUG_INFO, "SATA: Starting SATA controller at 0x%08X\n", SataBase));
+
+        InitializeSataController (SataBase);
+    }
 
     Status = gBS->CreateEventEx (
                     EVT_NOTIFY_SIGNAL,
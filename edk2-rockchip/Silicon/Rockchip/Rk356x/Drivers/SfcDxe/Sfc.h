@@ -0,0 +1,98 @@
+/** @file
+ *
+ *  RK356x serial flash controller (SFC) and SPI NOR definitions.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#ifndef SFC_H__
+#define SFC_H__
+
+/* SFC registers */
+#define SFC_CTRL                      0x0000
+#define  SFC_CTRL_PHASE_SEL_NEGATIVE  BIT1
+#define  SFC_CTRL_CMD_BITS_SHIFT      8
+#define  SFC_CTRL_ADDR_BITS_SHIFT     10
+#define  SFC_CTRL_DATA_BITS_SHIFT     12
+#define SFC_IMR                       0x0004
+#define SFC_ICLR                      0x0008
+#define SFC_FTLR                      0x000C
+#define SFC_RCVR                      0x0010
+#define  SFC_RCVR_RESET               BIT0
+#define SFC_AX                        0x0014
+#define SFC_ABIT                      0x0018
+#define SFC_ISR                       0x001C
+#define SFC_FSR                       0x0020
+#define  SFC_FSR_TXLV_SHIFT           8
+#define  SFC_FSR_TXLV_MASK            (0x1FU << SFC_FSR_TXLV_SHIFT)
+#define  SFC_FSR_RXLV_SHIFT           16
+#define  SFC_FSR_RXLV_MASK            (0x1FU << SFC_FSR_RXLV_SHIFT)
+#define SFC_SR                        0x0024
+#define  SFC_SR_IS_BUSY               BIT0
+#define SFC_RISR                      0x0028
+#define  SFC_RISR_DMA                 BIT7
+#define SFC_VER                       0x002C
+#define  SFC_VER_4                    0x4
+#define SFC_DMA_TRIGGER               0x0080
+#define  SFC_DMA_TRIGGER_START        BIT0
+#define SFC_DMA_ADDR                  0x0084
+#define SFC_LEN_CTRL                  0x0088
+#define  SFC_LEN_CTRL_TRB_SEL         BIT0
+#define SFC_LEN_EXT                   0x008C
+#define SFC_CMD                       0x0100
+#define  SFC_CMD_IDX_SHIFT            0
+#define  SFC_CMD_DUMMY_SHIFT          8
+#define  SFC_CMD_DIR_WR               BIT12
+#define  SFC_CMD_ADDR_SHIFT           14
+#define  SFC_CMD_ADDR_24BITS          (1U << SFC_CMD_ADDR_SHIFT)
+#define  SFC_CMD_ADDR_32BITS          (2U << SFC_CMD_ADDR_SHIFT)
+#define  SFC_CMD_TRAN_BYTES_SHIFT     16
+#define  SFC_CMD_TRAN_BYTES_MASK      (0x3FFFU << SFC_CMD_TRAN_BYTES_SHIFT)
+#define  SFC_CMD_CS_SHIFT             30
+#define SFC_ADDR                      0x0104
+#define SFC_DATA                      0x0108
+
+/* Bus widths, encoded as in the SFC_CTRL *_BITS fields */
+#define SFC_LINES_X1                  0
+#define SFC_LINES_X2                  1
+#define SFC_LINES_X4                  2
+
+/* Largest transfer supported by SFC versions before 4 */
+#define SFC_MAX_IOSIZE_VER3           512
+/* Transfers shorter than this go through the FIFO instead of DMA */
+#define SFC_DMA_THRESHOLD             64
+/* Size of the 32-bit addressable DMA bounce buffer */
+#define SFC_DMA_BUFFER_SIZE           SIZE_64KB
+
+/* SPI NOR opcodes */
+#define SPINOR_OP_WREN                0x06
+#define SPINOR_OP_RDSR                0x05
+#define SPINOR_OP_RDSR2               0x35
+#define SPINOR_OP_WRSR                0x01
+#define SPINOR_OP_RDID                0x9F
+#define SPINOR_OP_READ_FAST           0x0B
+#define SPINOR_OP_READ_FAST_4B        0x0C
+#define SPINOR_OP_READ_1_1_4          0x6B
+#define SPINOR_OP_READ_1_1_4_4B       0x6C
+
+/* Status register bits */
+#define SPINOR_SR_WIP                 BIT0
+#define SPINOR_SR1_QE_BIT6            BIT6
+#define SPINOR_SR2_QE_BIT1            BIT1
+
+/* JEDEC manufacturer IDs with a non-default quad enable bit */
+#define SPINOR_MFR_MACRONIX           0xC2
+#define SPINOR_MFR_ISSI               0x9D
+
+#define SPINOR_BLOCK_SIZE             512
+
+#define SPINOR_READ_DUMMY_CYCLES      8
+
+/* Timeouts (in μs) */
+#define SFC_IDLE_TIMEOUT              100000
+#define SPINOR_WRSR_TIMEOUT           100000
+
+#endif /* SFC_H__ */
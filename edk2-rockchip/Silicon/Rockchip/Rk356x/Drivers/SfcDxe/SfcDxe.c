@@ -0,0 +1,750 @@
+/** @file
+ *
+ *  SPI NOR flash driver for the RK356x serial flash controller (SFC).
+ *
+ *  Reads use the quad output fast read command when the flash has its
+ *  quad enable bit set, and anything larger than a FIFO's worth of data
+ *  is moved by the SFC DMA engine through a 32-bit addressable bounce
+ *  buffer. The flash is exposed read-only through the Block I/O protocol,
+ *  since nothing in it may be rewritten without a layout for the image.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/CacheMaintenanceLib.h>
+#include <Library/CruLib.h>
+#include <Library/DebugLib.h>
+#include <Library/GpioLib.h>
+#include <Library/IoLib.h>
+#include <Library/PcdLib.h>
+#include <Library/SocLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#include <Protocol/BlockIo.h>
+#include <Protocol/DevicePath.h>
+
+#include "Sfc.h"
+
+#define SFC_READ(Reg)           MmioRead32 (mSfcBase + (Reg))
+#define SFC_WRITE(Reg, Val)     MmioWrite32 (mSfcBase + (Reg), (Val))
+
+#pragma pack (1)
+typedef struct {
+  MEMMAP_DEVICE_PATH          MemMap;
+  EFI_DEVICE_PATH_PROTOCOL    End;
+} SFC_DEVICE_PATH;
+#pragma pack ()
+
+typedef struct {
+  UINT64                      ReadBytes;
+  UINT64                      ReadNs;
+} SFC_STATS;
+
+STATIC CONST GPIO_IOMUX_CONFIG mSfcIomuxConfig[] = {
+  { "fspi_clk",           1, GPIO_PIN_PD0, 1, GPIO_PIN_PULL_NONE, GPIO_PIN_DRIVE_DEFAULT },
+  { "fspi_cs0n",          1, GPIO_PIN_PD3, 1, GPIO_PIN_PULL_NONE, GPIO_PIN_DRIVE_DEFAULT },
+  { "fspi_d0",            1, GPIO_PIN_PD1, 1, GPIO_PIN_PULL_NONE, GPIO_PIN_DRIVE_DEFAULT },
+  { "fspi_d1",            1, GPIO_PIN_PD2, 1, GPIO_PIN_PULL_NONE, GPIO_PIN_DRIVE_DEFAULT },
+  { "fspi_d2",            1, GPIO_PIN_PC7, 2, GPIO_PIN_PULL_NONE, GPIO_PIN_DRIVE_DEFAULT },
+  { "fspi_d3",            1, GPIO_PIN_PD4, 1, GPIO_PIN_PULL_NONE, GPIO_PIN_DRIVE_DEFAULT },
+};
+
+STATIC EFI_PHYSICAL_ADDRESS mSfcBase;
+STATIC UINT32 mSfcVersion;
+STATIC UINT32 mSfcMaxIoSize;
+STATIC VOID *mSfcDmaBuffer;
+STATIC SFC_STATS mSfcStats;
+
+STATIC UINT8 mSpiNorId[3];
+STATIC UINT64 mSpiNorSize;
+STATIC UINT8 mSpiNorAddrBytes;
+STATIC UINT8 mSpiNorReadOpcode;
+STATIC UINT8 mSpiNorReadLines;
+
+STATIC SFC_DEVICE_PATH mSfcDevicePath = {
+  {
+    {
+      HARDWARE_DEVICE_PATH,
+      HW_MEMMAP_DP,
+      { (UINT8)sizeof (MEMMAP_DEVICE_PATH), (UINT8)(sizeof (MEMMAP_DEVICE_PATH) >> 8) }
+    },
+    EfiMemoryMappedIO,
+    0,
+    0
+  },
+  {
+    END_DEVICE_PATH_TYPE,
+    END_ENTIRE_DEVICE_PATH_SUBTYPE,
+    { sizeof (EFI_DEVICE_PATH_PROTOCOL), 0 }
+  }
+};
+
+STATIC
+UINT64
+SfcElapsedNs (
+  IN UINT64 Start
+  )
+{
+  return GetTimeInNanoSecond (GetPerformanceCounter () - Start);
+}
+
+STATIC
+BOOLEAN
+SfcTimedOut (
+  IN UINT64 Start,
+  IN UINTN  TimeoutUs
+  )
+{
+  return SfcElapsedNs (Start) >= MultU64x32 (TimeoutUs, 1000);
+}
+
+STATIC
+UINT64
+SfcRateKiB (
+  IN UINT64 Bytes,
+  IN UINT64 Ns
+  )
+{
+  if (Ns == 0) {
+    return 0;
+  }
+
+  // KiB/s = Bytes * (10^9 / 1024) / Ns, and 10^9 / 1024 == 1953125 / 2
+  return DivU64x64Remainder (MultU64x32 (Bytes, 1953125), MultU64x32 (Ns, 2), NULL);
+}
+
+STATIC
+EFI_STATUS
+SfcWaitIdle (
+  VOID
+  )
+{
+  UINT64 Start;
+
+  Start = GetPerformanceCounter ();
+  while ((SFC_READ (SFC_SR) & SFC_SR_IS_BUSY) != 0) {
+    if (SfcTimedOut (Start, SFC_IDLE_TIMEOUT)) {
+      return EFI_TIMEOUT;
+    }
+    MicroSecondDelay (1);
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+SfcReset (
+  VOID
+  )
+{
+  UINT64 Start;
+
+  SFC_WRITE (SFC_RCVR, SFC_RCVR_RESET);
+  Start = GetPerformanceCounter ();
+  while ((SFC_READ (SFC_RCVR) & SFC_RCVR_RESET) != 0) {
+    if (SfcTimedOut (Start, SFC_IDLE_TIMEOUT)) {
+      DEBUG ((DEBUG_WARN, "SfcDxe: Controller reset timed out\n"));
+      break;
+    }
+    MicroSecondDelay (1);
+  }
+  SFC_WRITE (SFC_ICLR, MAX_UINT32);
+}
+
+STATIC
+VOID
+SfcInit (
+  VOID
+  )
+{
+  SfcReset ();
+
+  SFC_WRITE (SFC_CTRL, 0);
+  SFC_WRITE (SFC_ICLR, MAX_UINT32);
+  // Mask all interrupts; completion is polled from the raw status.
+  SFC_WRITE (SFC_IMR, MAX_UINT32);
+
+  mSfcVersion = SFC_READ (SFC_VER) & 0xFFFF;
+  if (mSfcVersion >= SFC_VER_4) {
+    SFC_WRITE (SFC_LEN_CTRL, SFC_LEN_CTRL_TRB_SEL);
+    mSfcMaxIoSize = SFC_DMA_BUFFER_SIZE;
+  } else {
+    mSfcMaxIoSize = SFC_MAX_IOSIZE_VER3;
+  }
+}
+
+STATIC
+VOID
+SfcSetupTransfer (
+  IN UINT8    Opcode,
+  IN UINT8    AddrBytes,
+  IN UINT32   Address,
+  IN UINT8    DummyCycles,
+  IN UINT8    DataLines,
+  IN UINT32   Length,
+  IN BOOLEAN  Write
+  )
+{
+  UINT32 Ctrl;
+  UINT32 Cmd;
+
+  Ctrl = SFC_CTRL_PHASE_SEL_NEGATIVE;
+  Cmd = (UINT32)Opcode << SFC_CMD_IDX_SHIFT;
+
+  if (AddrBytes == 4) {
+    Cmd |= SFC_CMD_ADDR_32BITS;
+  } else if (AddrBytes == 3) {
+    Cmd |= SFC_CMD_ADDR_24BITS;
+  }
+
+  Cmd |= (UINT32)DummyCycles << SFC_CMD_DUMMY_SHIFT;
+
+  if (mSfcVersion >= SFC_VER_4) {
+    SFC_WRITE (SFC_LEN_EXT, Length);
+  } else {
+    Cmd |= (Length << SFC_CMD_TRAN_BYTES_SHIFT) & SFC_CMD_TRAN_BYTES_MASK;
+  }
+
+  if (Length > 0) {
+    Ctrl |= (UINT32)DataLines << SFC_CTRL_DATA_BITS_SHIFT;
+    if (Write) {
+      Cmd |= SFC_CMD_DIR_WR;
+    }
+  }
+
+  SFC_WRITE (SFC_CTRL, Ctrl);
+  SFC_WRITE (SFC_CMD, Cmd);
+  if (AddrBytes > 0) {
+    SFC_WRITE (SFC_ADDR, Address);
+  }
+}
+
+STATIC
+EFI_STATUS
+SfcFifoRead (
+  OUT UINT8   *Buffer,
+  IN  UINT32  Length
+  )
+{
+  UINT32 Level;
+  UINT32 Value;
+  UINT32 Count;
+  UINT64 Start;
+
+  while (Length > 0) {
+    Start = GetPerformanceCounter ();
+    while ((Level = (SFC_READ (SFC_FSR) & SFC_FSR_RXLV_MASK) >> SFC_FSR_RXLV_SHIFT) == 0) {
+      if (SfcTimedOut (Start, SFC_IDLE_TIMEOUT)) {
+        return EFI_TIMEOUT;
+      }
+      MicroSecondDelay (1);
+    }
+
+    while (Level-- > 0 && Length > 0) {
+      Value = SFC_READ (SFC_DATA);
+      Count = (UINT32)MIN (Length, sizeof (Value));
+      CopyMem (Buffer, &Value, Count);
+      Buffer += Count;
+      Length -= Count;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+SfcFifoWrite (
+  IN CONST UINT8  *Buffer,
+  IN UINT32       Length
+  )
+{
+  UINT32 Level;
+  UINT32 Value;
+  UINT32 Count;
+  UINT64 Start;
+
+  while (Length > 0) {
+    Start = GetPerformanceCounter ();
+    while ((Level = (SFC_READ (SFC_FSR) & SFC_FSR_TXLV_MASK) >> SFC_FSR_TXLV_SHIFT) == 0) {
+      if (SfcTimedOut (Start, SFC_IDLE_TIMEOUT)) {
+        return EFI_TIMEOUT;
+      }
+      MicroSecondDelay (1);
+    }
+
+    while (Level-- > 0 && Length > 0) {
+      Value = 0;
+      Count = (UINT32)MIN (Length, sizeof (Value));
+      CopyMem (&Value, Buffer, Count);
+      SFC_WRITE (SFC_DATA, Value);
+      Buffer += Count;
+      Length -= Count;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+SfcDmaTransfer (
+  VOID
+  )
+{
+  UINT64 Start;
+
+  SFC_WRITE (SFC_ICLR, MAX_UINT32);
+  SFC_WRITE (SFC_DMA_ADDR, (UINT32)(UINTN)mSfcDmaBuffer);
+  SFC_WRITE (SFC_DMA_TRIGGER, SFC_DMA_TRIGGER_START);
+
+  Start = GetPerformanceCounter ();
+  while ((SFC_READ (SFC_RISR) & SFC_RISR_DMA) == 0) {
+    if (SfcTimedOut (Start, SFC_IDLE_TIMEOUT)) {
+      return EFI_TIMEOUT;
+    }
+    MicroSecondDelay (1);
+  }
+  SFC_WRITE (SFC_ICLR, MAX_UINT32);
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+SfcTransfer (
+  IN     UINT8    Opcode,
+  IN     UINT8    AddrBytes,
+  IN     UINT32   Address,
+  IN     UINT8    DummyCycles,
+  IN     UINT8    DataLines,
+  IN OUT UINT8    *Data,
+  IN     UINT32   Length,
+  IN     BOOLEAN  Write
+  )
+{
+  EFI_STATUS Status;
+  BOOLEAN UseDma;
+
+  ASSERT (Length <= mSfcMaxIoSize);
+
+  UseDma = Length >= SFC_DMA_THRESHOLD;
+  if (UseDma) {
+    if (Write) {
+      CopyMem (mSfcDmaBuffer, Data, Length);
+      WriteBackDataCacheRange (mSfcDmaBuffer, Length);
+    } else {
+      WriteBackInvalidateDataCacheRange (mSfcDmaBuffer, Length);
+    }
+  }
+
+  SfcSetupTransfer (Opcode, AddrBytes, Address, DummyCycles, DataLines, Length, Write);
+
+  if (Length == 0) {
+    Status = EFI_SUCCESS;
+  } else if (UseDma) {
+    Status = SfcDmaTransfer ();
+  } else if (Write) {
+    Status = SfcFifoWrite (Data, Length);
+  } else {
+    Status = SfcFifoRead (Data, Length);
+  }
+  if (!EFI_ERROR (Status)) {
+    Status = SfcWaitIdle ();
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "SfcDxe: Command 0x%02X (addr 0x%X len %u) failed: %r\n",
+            Opcode, Address, Length, Status));
+    SfcReset ();
+    return Status;
+  }
+
+  if (UseDma && !Write) {
+    InvalidateDataCacheRange (mSfcDmaBuffer, Length);
+    CopyMem (Data, mSfcDmaBuffer, Length);
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+SpiNorCommand (
+  IN     UINT8    Opcode,
+  IN OUT UINT8    *Data,
+  IN     UINT32   Length,
+  IN     BOOLEAN  Write
+  )
+{
+  return SfcTransfer (Opcode, 0, 0, 0, SFC_LINES_X1, Data, Length, Write);
+}
+
+STATIC
+EFI_STATUS
+SpiNorWriteEnable (
+  VOID
+  )
+{
+  return SpiNorCommand (SPINOR_OP_WREN, NULL, 0, FALSE);
+}
+
+STATIC
+EFI_STATUS
+SpiNorWaitReady (
+  IN UINTN Timeout
+  )
+{
+  EFI_STATUS Status;
+  UINT8 Sr;
+  UINT64 Start;
+
+  // Each status read costs a full SFC command, so poll against the clock
+  // rather than counting iterations.
+  Start = GetPerformanceCounter ();
+  for (;;) {
+    Status = SpiNorCommand (SPINOR_OP_RDSR, &Sr, sizeof (Sr), FALSE);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    if ((Sr & SPINOR_SR_WIP) == 0) {
+      return EFI_SUCCESS;
+    }
+    if (SfcTimedOut (Start, Timeout)) {
+      break;
+    }
+    MicroSecondDelay (1);
+  }
+
+  DEBUG ((DEBUG_ERROR, "SfcDxe: Flash busy timeout\n"));
+  return EFI_TIMEOUT;
+}
+
+/**
+  Make sure the quad enable bit is set so that IO2/IO3 carry data
+  instead of acting as WP#/HOLD#.
+
+  @param[in]  Manufacturer    JEDEC manufacturer ID of the flash.
+
+  @retval TRUE                The flash can be read in quad mode.
+  @retval FALSE               Quad mode is unavailable.
+
+**/
+STATIC
+BOOLEAN
+SpiNorEnableQuad (
+  IN UINT8 Manufacturer
+  )
+{
+  EFI_STATUS Status;
+  UINT8 Sr[2];
+
+  Status = SpiNorCommand (SPINOR_OP_RDSR, &Sr[0], 1, FALSE);
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+
+  if (Manufacturer == SPINOR_MFR_MACRONIX || Manufacturer == SPINOR_MFR_ISSI) {
+    if ((Sr[0] & SPINOR_SR1_QE_BIT6) != 0) {
+      return TRUE;
+    }
+    Sr[0] |= SPINOR_SR1_QE_BIT6;
+    SpiNorWriteEnable ();
+    SpiNorCommand (SPINOR_OP_WRSR, Sr, 1, TRUE);
+    SpiNorWaitReady (SPINOR_WRSR_TIMEOUT);
+    Status = SpiNorCommand (SPINOR_OP_RDSR, &Sr[0], 1, FALSE);
+    return !EFI_ERROR (Status) && (Sr[0] & SPINOR_SR1_QE_BIT6) != 0;
+  }
+
+  Status = SpiNorCommand (SPINOR_OP_RDSR2, &Sr[1], 1, FALSE);
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+  if ((Sr[1] & SPINOR_SR2_QE_BIT1) != 0) {
+    return TRUE;
+  }
+  Sr[1] |= SPINOR_SR2_QE_BIT1;
+  SpiNorWriteEnable ();
+  SpiNorCommand (SPINOR_OP_WRSR, Sr, 2, TRUE);
+  SpiNorWaitReady (SPINOR_WRSR_TIMEOUT);
+  Status = SpiNorCommand (SPINOR_OP_RDSR2, &Sr[1], 1, FALSE);
+  return !EFI_ERROR (Status) && (Sr[1] & SPINOR_SR2_QE_BIT1) != 0;
+}
+
+STATIC
+EFI_STATUS
+SpiNorProbe (
+  VOID
+  )
+{
+  EFI_STATUS Status;
+  BOOLEAN Quad;
+
+  Status = SpiNorCommand (SPINOR_OP_RDID, mSpiNorId, sizeof (mSpiNorId), FALSE);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (mSpiNorId[0] == 0x00 || mSpiNorId[0] == 0xFF) {
+    DEBUG ((DEBUG_INFO, "SfcDxe: No SPI NOR flash found\n"));
+    return EFI_NOT_FOUND;
+  }
+
+  // The third ID byte is log2(size) for all common parts up to 256Mbit.
+  if (mSpiNorId[2] >= 0x10 && mSpiNorId[2] <= 0x19) {
+    mSpiNorSize = LShiftU64 (1, mSpiNorId[2]);
+  } else if (mSpiNorId[2] == 0x20 || mSpiNorId[2] == 0x21) {
+    mSpiNorSize = LShiftU64 (SIZE_64MB, mSpiNorId[2] - 0x20);
+  } else {
+    DEBUG ((DEBUG_ERROR, "SfcDxe: Unsupported flash %02X %02X %02X\n",
+            mSpiNorId[0], mSpiNorId[1], mSpiNorId[2]));
+    return EFI_UNSUPPORTED;
+  }
+
+  mSpiNorAddrBytes = mSpiNorSize > SIZE_16MB ? 4 : 3;
+  Quad = SpiNorEnableQuad (mSpiNorId[0]);
+
+  if (mSpiNorAddrBytes == 4) {
+    mSpiNorReadOpcode = Quad ? SPINOR_OP_READ_1_1_4_4B : SPINOR_OP_READ_FAST_4B;
+  } else {
+    mSpiNorReadOpcode = Quad ? SPINOR_OP_READ_1_1_4 : SPINOR_OP_READ_FAST;
+  }
+  mSpiNorReadLines = Quad ? SFC_LINES_X4 : SFC_LINES_X1;
+
+  DEBUG ((DEBUG_INFO, "SfcDxe: SFC v%u, flash %02X %02X %02X, %lu MiB, %a read\n",
+          mSfcVersion, mSpiNorId[0], mSpiNorId[1], mSpiNorId[2],
+          RShiftU64 (mSpiNorSize, 20), Quad ? "quad" : "single"));
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+SpiNorRead (
+  IN  UINT64  Offset,
+  OUT UINT8   *Buffer,
+  IN  UINTN   Length
+  )
+{
+  EFI_STATUS Status;
+  UINT32 Count;
+
+  while (Length > 0) {
+    Count = (UINT32)MIN (Length, mSfcMaxIoSize);
+    Status = SfcTransfer (mSpiNorReadOpcode, mSpiNorAddrBytes, (UINT32)Offset,
+               SPINOR_READ_DUMMY_CYCLES, mSpiNorReadLines, Buffer, Count, FALSE);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    Offset += Count;
+    Buffer += Count;
+    Length -= Count;
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_BLOCK_IO_MEDIA mSfcMedia = {
+  0,                      // MediaId
+  FALSE,                  // RemovableMedia
+  TRUE,                   // MediaPresent
+  FALSE,                  // LogicalPartition
+  TRUE,                   // ReadOnly
+  FALSE,                  // WriteCaching
+  SPINOR_BLOCK_SIZE,      // BlockSize
+  0,                      // IoAlign
+  0                       // LastBlock
+};
+
+STATIC
+EFI_STATUS
+SfcCheckRequest (
+  IN UINT32   MediaId,
+  IN EFI_LBA  Lba,
+  IN UINTN    BufferSize,
+  IN VOID     *Buffer
+  )
+{
+  if (MediaId != mSfcMedia.MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+  if (Buffer == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+  if ((BufferSize % SPINOR_BLOCK_SIZE) != 0) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+  if (Lba > mSfcMedia.LastBlock ||
+      BufferSize / SPINOR_BLOCK_SIZE > mSfcMedia.LastBlock - Lba + 1) {
+    return EFI_INVALID_PARAMETER;
+  }
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+SfcBlockIoReset (
+  IN EFI_BLOCK_IO_PROTOCOL  *This,
+  IN BOOLEAN                ExtendedVerification
+  )
+{
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+SfcBlockIoReadBlocks (
+  IN  EFI_BLOCK_IO_PROTOCOL   *This,
+  IN  UINT32                  MediaId,
+  IN  EFI_LBA                 Lba,
+  IN  UINTN                   BufferSize,
+  OUT VOID                    *Buffer
+  )
+{
+  EFI_STATUS Status;
+  UINT64 Start;
+
+  if (BufferSize == 0) {
+    return EFI_SUCCESS;
+  }
+  Status = SfcCheckRequest (MediaId, Lba, BufferSize, Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Start = GetPerformanceCounter ();
+  Status = SpiNorRead (MultU64x32 (Lba, SPINOR_BLOCK_SIZE), Buffer, BufferSize);
+  mSfcStats.ReadNs += SfcElapsedNs (Start);
+  mSfcStats.ReadBytes += BufferSize;
+
+  return EFI_ERROR (Status) ? EFI_DEVICE_ERROR : EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+SfcBlockIoWriteBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL    *This,
+  IN UINT32                   MediaId,
+  IN EFI_LBA                  Lba,
+  IN UINTN                    BufferSize,
+  IN VOID                     *Buffer
+  )
+{
+  // The flash holds the firmware, and there is no layout yet that sets part
+  // of it aside for data.
+  return EFI_WRITE_PROTECTED;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+SfcBlockIoFlushBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This
+  )
+{
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_BLOCK_IO_PROTOCOL mSfcBlockIo = {
+  EFI_BLOCK_IO_PROTOCOL_REVISION,
+  &mSfcMedia,
+  SfcBlockIoReset,
+  SfcBlockIoReadBlocks,
+  SfcBlockIoWriteBlocks,
+  SfcBlockIoFlushBlocks
+};
+
+/**
+  Report the flash throughput seen during boot.
+
+  @param[in]  Event             The ExitBootServices event.
+  @param[in]  Context           Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+SfcExitBootServices (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  DEBUG ((DEBUG_INFO, "SfcDxe: Read %lu KiB at %lu KiB/s\n",
+          RShiftU64 (mSfcStats.ReadBytes, 10),
+          SfcRateKiB (mSfcStats.ReadBytes, mSfcStats.ReadNs)));
+}
+
+EFI_STATUS
+EFIAPI
+SfcDxeInitialize (
+  IN EFI_HANDLE         ImageHandle,
+  IN EFI_SYSTEM_TABLE   *SystemTable
+  )
+{
+  EFI_STATUS Status;
+  EFI_PHYSICAL_ADDRESS DmaBuffer;
+  EFI_HANDLE Handle;
+  EFI_EVENT Event;
+
+  if (SocGetBootDevice () != SOC_BOOT_DEVICE_SPINOR) {
+    if (FixedPcdGet8 (PcdSfcStatus) == 0) {
+      return EFI_UNSUPPORTED;
+    }
+    // The boot ROM only sets up the pins when it booted from SPI NOR.
+    GpioSetIomuxConfig (mSfcIomuxConfig, ARRAY_SIZE (mSfcIomuxConfig));
+  }
+
+  mSfcBase = PcdGet32 (PcdSfcDxeBaseAddress);
+
+  CruSetSfcClockRate (PcdGet32 (PcdSfcDxeClockRate));
+  SfcInit ();
+
+  // The SFC DMA engine only takes 32-bit addresses.
+  DmaBuffer = MAX_UINT32;
+  Status = gBS->AllocatePages (AllocateMaxAddress, EfiBootServicesData,
+                  EFI_SIZE_TO_PAGES (SFC_DMA_BUFFER_SIZE), &DmaBuffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  mSfcDmaBuffer = (VOID *)(UINTN)DmaBuffer;
+
+  Status = SpiNorProbe ();
+  if (EFI_ERROR (Status)) {
+    goto Error;
+  }
+
+  mSfcMedia.LastBlock = DivU64x32 (mSpiNorSize, SPINOR_BLOCK_SIZE) - 1;
+  mSfcDevicePath.MemMap.StartingAddress = mSfcBase;
+  mSfcDevicePath.MemMap.EndingAddress = mSfcBase + SFC_DATA + 3;
+
+  Handle = NULL;
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &Handle,
+                  &gEfiBlockIoProtocolGuid, &mSfcBlockIo,
+                  &gEfiDevicePathProtocolGuid, &mSfcDevicePath,
+                  NULL
+                  );
+  if (EFI_ERROR (Status)) {
+    goto Error;
+  }
+
+  Status = gBS->CreateEvent (EVT_SIGNAL_EXIT_BOOT_SERVICES, TPL_NOTIFY,
+                  SfcExitBootServices, NULL, &Event);
+  ASSERT_EFI_ERROR (Status);
+
+  return EFI_SUCCESS;
+
+Error:
+  gBS->FreePages (DmaBuffer, EFI_SIZE_TO_PAGES (SFC_DMA_BUFFER_SIZE));
+  return Status;
+}
@@ -34,6 +34,7 @@
 #define CRU_PLL_CON0_FBDIV_MASK                  0xfffU
 
 /* PLL_CON1 fields */
+#define CRU_PLL_CON1_PWRDOWN                     BIT13
 #define CRU_PLL_CON1_DSMPD                       BIT12
 #define CRU_PLL_CON1_LOCK_STATUS                 BIT10
 #define CRU_PLL_CON1_POSTDIV2_SHIFT              6
@@ -65,6 +66,8 @@
 #define CRU_CLKSEL_CON28_CCLK_EMMC_SEL_MASK      (0x7U << CRU_CLKSEL_CON28_CCLK_EMMC_SEL_SHIFT)
 #define CRU_CLKSEL_CON28_BCLK_EMMC_SEL_SHIFT     8
 #define CRU_CLKSEL_CON28_BCLK_EMMC_SEL_MASK      (0x3U << CRU_CLKSEL_CON28_BCLK_EMMC_SEL_SHIFT)
+#define CRU_CLKSEL_CON28_SCLK_SFC_SEL_SHIFT      4
+#define CRU_CLKSEL_CON28_SCLK_SFC_SEL_MASK       (0x7U << CRU_CLKSEL_CON28_SCLK_SFC_SEL_SHIFT)
 
 /* CLKSEL_CON30 fields */
 #define CRU_CLKSEL_CON30_CLK_SDMMC1_SEL_SHIFT    12
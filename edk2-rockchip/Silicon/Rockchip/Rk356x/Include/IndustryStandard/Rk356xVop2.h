@@ -197,6 +197,7 @@
 #define  VOP2_ESMART_REGION0_MST_CTL_DATA_FMT_SHIFT     1
 #define  VOP2_ESMART_REGION0_MST_CTL_DATA_FMT_MASK      (0x1FU << VOP2_ESMART_REGION0_MST_CTL_DATA_FMT_SHIFT)
 #define  VOP2_ESMART_REGION0_MST_CTL_DATA_FMT_ARGB8888  (0U << VOP2_ESMART_REGION0_MST_CTL_DATA_FMT_SHIFT)
+#define  VOP2_ESMART_REGION0_MST_CTL_DATA_FMT_RGB565    (2U << VOP2_ESMART_REGION0_MST_CTL_DATA_FMT_SHIFT)
 #define  VOP2_ESMART_REGION0_MST_CTL_MST_ENABLE         BIT0
 #define VOP2_ESMART_REGION0_MST_YRGB(n)         (VOP2_ESMARTn_BASE(n) + 0x0014)
 #define VOP2_ESMART_REGION0_MST_CBCR(n)         (VOP2_ESMARTn_BASE(n) + 0x0018)
@@ -32,6 +32,12 @@ CruEnableClock (
   IN UINT8 Bit
   );
 
+VOID
+CruDisableClock (
+  IN UINT32 Index,
+  IN UINT8 Bit
+  );
+
 VOID
 PmuCruEnableClock (
   IN UINT32 Index,
@@ -54,6 +60,11 @@ CruSetEmmcClockRate (
   IN UINTN Rate
   );
 
+VOID
+CruSetSfcClockRate (
+  IN UINTN Rate
+  );
+
 VOID
 CruSetPciePhySource (
   IN UINT8 Index,
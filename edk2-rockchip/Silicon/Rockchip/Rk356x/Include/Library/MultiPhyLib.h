@@ -21,4 +21,15 @@ MultiPhySetMode (
   IN MULTIPHY_MODE Mode
   );
 
+/*
+ * SATA PHY tuning 0 is the setting applied by MultiPhySetMode; higher
+ * numbers are alternates to try on a degraded link. Returns EFI_NOT_FOUND
+ * past the last one.
+ */
+EFI_STATUS
+MultiPhySetSataTuning (
+  IN UINT8 Index,
+  IN UINT8 Tuning
+  );
+
 #endif /* MULTIPHYLIB_H__ */
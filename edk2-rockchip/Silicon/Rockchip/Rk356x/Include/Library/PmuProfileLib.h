@@ -0,0 +1,104 @@
+/** @file
+ *
+ *  Cortex-A55 PMU based profiling of named code regions.
+ *
+ *  Usage:
+ *
+ *    PMU_PROFILE_DEFINE (mBltProfile, "DisplayBlt");
+ *
+ *    PMU_PROFILE_BEGIN (mBltProfile);
+ *    ...
+ *    PMU_PROFILE_END (mBltProfile);
+ *
+ *  Each region collects a call count, cycle totals, a log2 histogram of
+ *  cycles per call and totals for the two events selected by
+ *  PcdPmuProfileEvent0/1. Regions from every module are published through
+ *  the gRk356xPmuProfileTableGuid configuration table for the PmuProfile
+ *  shell application to dump.
+ *
+ *  All of the macros compile to nothing unless PcdPmuProfileEnable is set.
+ *  Regions must not nest with themselves, and may only be used while boot
+ *  services are available.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#ifndef PMUPROFILELIB_H__
+#define PMUPROFILELIB_H__
+
+#include <Library/PcdLib.h>
+
+#define PMU_PROFILE_EVENTS        2
+#define PMU_PROFILE_BUCKETS       32
+#define PMU_PROFILE_MAX_REGIONS   64
+
+#define PMU_PROFILE_TABLE_SIGNATURE   SIGNATURE_32 ('P', 'M', 'U', 'P')
+
+typedef struct {
+  CONST CHAR8   *Name;
+  BOOLEAN       Registered;
+  UINT64        StartCycles;
+  UINT32        StartEvents[PMU_PROFILE_EVENTS];
+  UINT64        Count;
+  UINT64        TotalCycles;
+  UINT64        MinCycles;
+  UINT64        MaxCycles;
+  UINT64        TotalEvents[PMU_PROFILE_EVENTS];
+  // Histogram[n] counts calls that took [2^n, 2^(n+1)) cycles
+  UINT32        Histogram[PMU_PROFILE_BUCKETS];
+} PMU_PROFILE_REGION;
+
+typedef struct {
+  UINT32              Signature;
+  UINT32              NumRegions;
+  UINT32              Events[PMU_PROFILE_EVENTS];
+  PMU_PROFILE_REGION  *Regions[PMU_PROFILE_MAX_REGIONS];
+} PMU_PROFILE_TABLE;
+
+#define PMU_PROFILE_ENABLED()     FeaturePcdGet (PcdPmuProfileEnable)
+
+#define PMU_PROFILE_DEFINE(Region, RegionName) \
+  STATIC PMU_PROFILE_REGION Region = { RegionName }
+
+#define PMU_PROFILE_BEGIN(Region)           \
+  do {                                      \
+    if (PMU_PROFILE_ENABLED ()) {           \
+      PmuProfileBegin (&(Region));          \
+    }                                       \
+  } while (FALSE)
+
+#define PMU_PROFILE_END(Region)             \
+  do {                                      \
+    if (PMU_PROFILE_ENABLED ()) {           \
+      PmuProfileEnd (&(Region));            \
+    }                                       \
+  } while (FALSE)
+
+/**
+  Start timing a region, registering it and enabling the PMU on first use.
+
+  @param[in]  Region            The region being entered.
+
+**/
+VOID
+EFIAPI
+PmuProfileBegin (
+  IN PMU_PROFILE_REGION  *Region
+  );
+
+/**
+  Stop timing a region and account the sample.
+
+  @param[in]  Region            The region being left.
+
+**/
+VOID
+EFIAPI
+PmuProfileEnd (
+  IN PMU_PROFILE_REGION  *Region
+  );
+
+#endif /* PMUPROFILELIB_H__ */
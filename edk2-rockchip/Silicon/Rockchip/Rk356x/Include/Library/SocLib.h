@@ -35,6 +35,18 @@ typedef enum {
   VCC_3V3
 } PMU_IO_VOLTAGE;
 
+typedef enum {
+  PMU_PD_GPU,
+  PMU_PD_NPU,
+  PMU_PD_VPU,
+  PMU_PD_RKVENC,
+  PMU_PD_RKVDEC,
+  PMU_PD_RGA,
+  PMU_PD_VI,
+  PMU_PD_VO,
+  PMU_PD_PIPE,
+} PMU_POWER_DOMAIN;
+
 SOC_BOOT_DEVICE
 SocGetBootDevice (
     VOID
@@ -46,4 +58,10 @@ SocSetDomainVoltage (
     PMU_IO_VOLTAGE IoVoltage
     );
 
+EFI_STATUS
+SocSetPowerDomain (
+    PMU_POWER_DOMAIN PowerDomain,
+    BOOLEAN Enable
+    );
+
 #endif /* SOCLIB_H__ */
\ No newline at end of file
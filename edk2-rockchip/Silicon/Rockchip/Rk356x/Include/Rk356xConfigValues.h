@@ -0,0 +1,43 @@
+/** @file
+ *
+ *  Values of the setup options that silicon drivers read back through
+ *  PCDs. Shared by the drivers and by ConfigVars.h, which the setup form
+ *  is built from, so both always agree.
+ *
+ *  Only #defines belong here; the file is also run through VfrCompile.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#ifndef RK356X_CONFIG_VALUES_H__
+#define RK356X_CONFIG_VALUES_H__
+
+/* PcdEmmcBusMode */
+#define EMMC_BUS_MODE_AUTO            0
+#define EMMC_BUS_MODE_HS400ES         1
+#define EMMC_BUS_MODE_HS400           2
+#define EMMC_BUS_MODE_HS200           3
+#define EMMC_BUS_MODE_HS52            4
+
+/* PcdEmmcCurrentBusMode */
+#define EMMC_STATUS_MODE_NONE         0
+#define EMMC_STATUS_MODE_LEGACY       1
+#define EMMC_STATUS_MODE_HS52         2
+#define EMMC_STATUS_MODE_DDR52        3
+#define EMMC_STATUS_MODE_HS200        4
+#define EMMC_STATUS_MODE_HS400        5
+#define EMMC_STATUS_MODE_HS400ES      6
+
+/* PcdDisplayPowerPolicy */
+#define DISPLAY_POWER_ALWAYS_ON       0
+#define DISPLAY_POWER_OFF_HEADLESS    1
+#define DISPLAY_POWER_OFF_AT_EBS      2
+
+/* PcdDisplayColorDepth */
+#define DISPLAY_COLOR_DEPTH_16        16
+#define DISPLAY_COLOR_DEPTH_32        32
+
+#endif /* RK356X_CONFIG_VALUES_H__ */
@@ -27,6 +27,10 @@ typedef struct {
     UINT32 Frac;
 } CRU_PLL_RATE;
 
+/* PLLs normally lock within tens of microseconds */
+#define CRU_PLL_LOCK_POLL_US        5
+#define CRU_PLL_LOCK_TIMEOUT_US     100000
+
 STATIC CRU_PLL_RATE CruPllRates[] = {
     { .Rate = 1200000000, .RefDiv = 1, .FbDiv = 100, .PostDiv1 = 2, .PostDiv2 = 1, .Dsmpd = 1, .Frac = 0 },
     { .Rate = 594000000,  .RefDiv = 1, .FbDiv = 99,  .PostDiv1 = 4, .PostDiv2 = 1, .Dsmpd = 1, .Frac = 0 },
@@ -71,13 +75,34 @@ CruGetPllRate (
     return FOutVco / PostDiv1 / PostDiv2;
 }
 
+STATIC BOOLEAN
+CruWaitPllLock (
+  IN UINTN Con1Reg
+  )
+{
+    UINT64 Start;
+    UINT32 Waited;
+
+    Start = GetPerformanceCounter ();
+    for (Waited = 0; Waited < CRU_PLL_LOCK_TIMEOUT_US; Waited += CRU_PLL_LOCK_POLL_US) {
+        if ((MmioRead32 (Con1Reg) & CRU_PLL_CON1_LOCK_STATUS) != 0) {
+            DEBUG ((DEBUG_INFO, "CruWaitPllLock(): 0x%lX locked in %lu us\n", Con1Reg,
+                    DivU64x32 (GetTimeInNanoSecond (GetPerformanceCounter () - Start), 1000)));
+            return TRUE;
+        }
+        MicroSecondDelay (CRU_PLL_LOCK_POLL_US);
+    }
+
+    DEBUG ((DEBUG_ERROR, "CruWaitPllLock(): 0x%lX not locked after %u us\n", Con1Reg, CRU_PLL_LOCK_TIMEOUT_US));
+    return FALSE;
+}
+
 STATIC VOID
 CruSetPllRate (
   IN UINT32 PllNumber,
   IN CRU_PLL_RATE *Rate
   )
 {
-    UINT32 PllLockRetry = 0;
     UINTN ModeIndex;
 
     ASSERT (PllNumber == CRU_GPLL);
@@ -92,6 +117,9 @@ CruSetPllRate (
                  (CRU_MODE_CON00_CLK_PLL_MODE_MASK (ModeIndex) << 16) |
                  (0U << PMUCRU_MODE_CON00_CLK_PLL_MODE_SHIFT (ModeIndex)));
 
+    /* Hold the PLL in power-down while the dividers change, as U-Boot does */
+    MmioWrite32 (CRU_PLL_CON1 (PllNumber), (CRU_PLL_CON1_PWRDOWN << 16) | CRU_PLL_CON1_PWRDOWN);
+
     MmioWrite32 (CRU_PLL_CON0 (PllNumber),
                  ((CRU_PLL_CON0_FBDIV_MASK | CRU_PLL_CON0_POSTDIV1_MASK | CRU_PLL_CON0_BYPASS) << 16) |
                  (Rate->PostDiv1 << CRU_PLL_CON0_POSTDIV1_SHIFT) |
@@ -105,14 +133,11 @@ CruSetPllRate (
 
     MmioAndThenOr32 (CRU_PLL_CON2 (PllNumber), ~CRU_PLL_CON2_FRACDIV_MASK, Rate->Frac);
 
-    do {
-        UINT32 Val = MmioRead32 (CRU_PLL_CON1 (PllNumber));
-        if ((Val & CRU_PLL_CON1_LOCK_STATUS) != 0) {
-            break;
-        }
-        MicroSecondDelay (1000);
-    } while (++PllLockRetry < 100);
-    ASSERT (PllLockRetry < 100);
+    MmioWrite32 (CRU_PLL_CON1 (PllNumber), CRU_PLL_CON1_PWRDOWN << 16);
+
+    if (!CruWaitPllLock (CRU_PLL_CON1 (PllNumber))) {
+        ASSERT (FALSE);
+    }
 
     MmioWrite32 (CRU_MODE_CON00,
                  (CRU_MODE_CON00_CLK_PLL_MODE_MASK (ModeIndex) << 16) |
@@ -159,12 +184,13 @@ PmuCruSetPllRate (
   IN CRU_PLL_RATE *Rate
   )
 {
-    UINT32 PllLockRetry = 0;
-
     MmioWrite32 (PMUCRU_MODE_CON00,
                  (PMUCRU_MODE_CON00_CLK_PLL_MODE_MASK (PllNumber) << 16) |
                  (0U << PMUCRU_MODE_CON00_CLK_PLL_MODE_SHIFT (PllNumber)));
 
+    /* Hold the PLL in power-down while the dividers change, as U-Boot does */
+    MmioWrite32 (PMUCRU_PLL_CON1 (PllNumber), (CRU_PLL_CON1_PWRDOWN << 16) | CRU_PLL_CON1_PWRDOWN);
+
     MmioWrite32 (PMUCRU_PLL_CON0 (PllNumber),
                  ((CRU_PLL_CON0_FBDIV_MASK | CRU_PLL_CON0_POSTDIV1_MASK | CRU_PLL_CON0_BYPASS) << 16) |
                  (Rate->PostDiv1 << CRU_PLL_CON0_POSTDIV1_SHIFT) |
@@ -178,14 +204,11 @@ PmuCruSetPllRate (
 
     MmioAndThenOr32 (PMUCRU_PLL_CON2 (PllNumber), ~CRU_PLL_CON2_FRACDIV_MASK, Rate->Frac);
 
-    do {
-        UINT32 Val = MmioRead32 (PMUCRU_PLL_CON1 (PllNumber));
-        if ((Val & CRU_PLL_CON1_LOCK_STATUS) != 0) {
-            break;
-        }
-        MicroSecondDelay (1000);
-    } while (++PllLockRetry < 100);
-    ASSERT (PllLockRetry < 100);
+    MmioWrite32 (PMUCRU_PLL_CON1 (PllNumber), CRU_PLL_CON1_PWRDOWN << 16);
+
+    if (!CruWaitPllLock (PMUCRU_PLL_CON1 (PllNumber))) {
+        ASSERT (FALSE);
+    }
 
     MmioWrite32 (PMUCRU_MODE_CON00,
                  (PMUCRU_MODE_CON00_CLK_PLL_MODE_MASK (PllNumber) << 16) |
@@ -365,6 +388,35 @@ CruSetEmmcClockRate (
     DEBUG ((DEBUG_INFO, "CruSetEmmcClockRate(%lu): CRU_CLKSEL_CON28 = %08X (wrote %08X)\n", Rate, MmioRead32 (CRU_CLKSEL_CON (28)), Val));
 }
 
+VOID
+CruSetSfcClockRate (
+  IN UINTN Rate
+  )
+{
+    UINT32 Val;
+    UINT32 Sel;
+
+    if (Rate >= 150000000U) {
+      Sel = 5;
+    } else if (Rate >= 125000000U) {
+      Sel = 4;
+    } else if (Rate >= 100000000U) {
+      Sel = 3;
+    } else if (Rate >= 75000000U) {
+      Sel = 2;
+    } else if (Rate >= 50000000U) {
+      Sel = 1;
+    } else {
+      Sel = 0;
+    }
+
+    Val = CRU_CLKSEL_CON28_SCLK_SFC_SEL_MASK << 16;
+    Val |= Sel << CRU_CLKSEL_CON28_SCLK_SFC_SEL_SHIFT;
+    MmioWrite32 (CRU_CLKSEL_CON (28), Val);
+
+    DEBUG ((DEBUG_INFO, "CruSetSfcClockRate(%lu): CRU_CLKSEL_CON28 = %08X (wrote %08X)\n", Rate, MmioRead32 (CRU_CLKSEL_CON (28)), Val));
+}
+
 VOID
 CruSetPciePhySource (
   IN UINT8 Index,
@@ -476,6 +528,15 @@ CruEnableClock (
     MmioWrite32 (CRU_GATE_CON (Index), 1U << (Bit + 16));
 }
 
+VOID
+CruDisableClock (
+  IN UINT32 Index,
+  IN UINT8 Bit
+  )
+{
+    MmioWrite32 (CRU_GATE_CON (Index), (1U << (Bit + 16)) | (1U << Bit));
+}
+
 VOID
 PmuCruEnableClock (
   IN UINT32 Index,
@@ -61,6 +61,28 @@
 #define SOFTRST_INDEX               28
 #define SOFTRST_BIT(n)              (5 + (n) * 2)
 
+/* PHY registers */
+#define  PHYREG7_TX_RTERM_SHIFT     4
+#define  PHYREG7_RX_RTERM_SHIFT     0
+#define  PHYREG15_CTLE_EN           BIT0
+
+/*
+ * Termination is 60 ohm at 0 and 44 ohm at 15, in roughly 1 ohm steps.
+ */
+typedef struct {
+    UINT8   TxRterm;
+    UINT8   RxRterm;
+    BOOLEAN Ctle;
+} SATA_PHY_TUNING;
+
+STATIC CONST SATA_PHY_TUNING mSataPhyTuning[] = {
+    { 0x8, 0xF, TRUE },     /* 50 ohm TX, 44 ohm RX, adaptive CTLE (default) */
+    { 0x4, 0xF, TRUE },     /* 56 ohm TX, 44 ohm RX, adaptive CTLE */
+    { 0xF, 0xF, TRUE },     /* 44 ohm TX, 44 ohm RX, adaptive CTLE */
+    { 0x8, 0x8, TRUE },     /* 50 ohm TX, 50 ohm RX, adaptive CTLE */
+    { 0x8, 0xF, FALSE },    /* 50 ohm TX, 44 ohm RX, fixed equalizer */
+};
+
 STATIC
 VOID
 GrfUpdateRegister (
@@ -72,6 +94,27 @@ GrfUpdateRegister (
     MmioWrite32 (Reg, (Mask << 16) | Val);
 }
 
+STATIC
+VOID
+MultiPhyApplySataTuning (
+  IN EFI_PHYSICAL_ADDRESS BaseAddr,
+  IN UINT8 Tuning
+  )
+{
+    CONST SATA_PHY_TUNING *Settings;
+
+    Settings = &mSataPhyTuning[Tuning];
+
+    if (Settings->Ctle) {
+        MmioOr32 (BaseAddr + MULTIPHY_REGISTER (15), PHYREG15_CTLE_EN);
+    } else {
+        MmioAnd32 (BaseAddr + MULTIPHY_REGISTER (15), ~PHYREG15_CTLE_EN);
+    }
+    MmioWrite32 (BaseAddr + MULTIPHY_REGISTER (7),
+                 ((Settings->TxRterm & 0xF) << PHYREG7_TX_RTERM_SHIFT) |
+                 ((Settings->RxRterm & 0xF) << PHYREG7_RX_RTERM_SHIFT));
+}
+
 STATIC
 EFI_STATUS
 MultiPhySetModePcie (
@@ -215,8 +258,7 @@ MultiPhySetModeSata (
     Rate = CruGetPciePhyClockRate (Index);
     ASSERT (Rate == 100000000);
 
-    MmioOr32 (BaseAddr + MULTIPHY_REGISTER (15), BIT0);
-    MmioWrite32 (BaseAddr + MULTIPHY_REGISTER (7), 0x8F);
+    MultiPhyApplySataTuning (BaseAddr, 0);
 
     GrfUpdateRegister (PhyGrfBaseAddr + PIPE_PHY_GRF_PIPE_CON0, 0xFFFF, 0x0119);
     GrfUpdateRegister (PhyGrfBaseAddr + PIPE_PHY_GRF_PIPE_CON1, 0xFFFF, 0x0040);
@@ -293,5 +335,26 @@ MultiPhySetMode (
     /* De-assert reset */
     CruDeassertSoftReset (SOFTRST_INDEX, SOFTRST_BIT (Index));
 
+    return EFI_SUCCESS;
+}
+
+EFI_STATUS
+MultiPhySetSataTuning (
+  IN UINT8 Index,
+  IN UINT8 Tuning
+  )
+{
+    ASSERT (Index <= 2);
+
+    if (Tuning >= ARRAY_SIZE (mSataPhyTuning)) {
+        return EFI_NOT_FOUND;
+    }
+
+    DEBUG ((DEBUG_INFO, "MultiPhySetSataTuning(%u, %u)\n", Index, Tuning));
+
+    CruAssertSoftReset (SOFTRST_INDEX, SOFTRST_BIT (Index));
+    MultiPhyApplySataTuning (PIPE_PHY (Index), Tuning);
+    CruDeassertSoftReset (SOFTRST_INDEX, SOFTRST_BIT (Index));
+
     return EFI_SUCCESS;
 }
\ No newline at end of file
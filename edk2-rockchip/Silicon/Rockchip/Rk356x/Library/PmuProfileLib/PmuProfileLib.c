@@ -0,0 +1,171 @@
+/** @file
+ *
+ *  Cortex-A55 PMU based profiling of named code regions.
+ *
+ *  Copyright (c) 2026, Quartz64 UEFI contributors
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
+#include <Library/PmuProfileLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+
+VOID
+PmuProfileEnableCounters (
+  IN UINT32  Event0,
+  IN UINT32  Event1
+  );
+
+UINT64
+PmuProfileReadCycles (
+  VOID
+  );
+
+VOID
+PmuProfileReadEvents (
+  OUT UINT32  *Events
+  );
+
+STATIC PMU_PROFILE_TABLE *mPmuProfileTable;
+
+/* Regions registered by this module, removed from the table on unload */
+STATIC PMU_PROFILE_REGION *mModuleRegions[PMU_PROFILE_MAX_REGIONS];
+STATIC UINTN mNumModuleRegions;
+
+/**
+  Find the table shared by all modules, creating it and starting the
+  counters if this is the first region registered during this boot.
+
+**/
+STATIC
+PMU_PROFILE_TABLE *
+PmuProfileGetTable (
+  VOID
+  )
+{
+  EFI_STATUS Status;
+  PMU_PROFILE_TABLE *Table;
+
+  if (mPmuProfileTable != NULL) {
+    return mPmuProfileTable;
+  }
+
+  Status = EfiGetSystemConfigurationTable (&gRk356xPmuProfileTableGuid, (VOID **)&Table);
+  if (EFI_ERROR (Status)) {
+    Table = AllocateZeroPool (sizeof (PMU_PROFILE_TABLE));
+    if (Table == NULL) {
+      return NULL;
+    }
+    Table->Signature = PMU_PROFILE_TABLE_SIGNATURE;
+    Table->Events[0] = FixedPcdGet32 (PcdPmuProfileEvent0);
+    Table->Events[1] = FixedPcdGet32 (PcdPmuProfileEvent1);
+
+    PmuProfileEnableCounters (Table->Events[0], Table->Events[1]);
+
+    Status = gBS->InstallConfigurationTable (&gRk356xPmuProfileTableGuid, Table);
+    if (EFI_ERROR (Status)) {
+      FreePool (Table);
+      return NULL;
+    }
+  }
+
+  mPmuProfileTable = Table;
+  return Table;
+}
+
+STATIC
+VOID
+PmuProfileRegister (
+  IN PMU_PROFILE_REGION  *Region
+  )
+{
+  PMU_PROFILE_TABLE *Table;
+
+  // Only try once; a full table just means the region is not reported.
+  Region->Registered = TRUE;
+  Region->MinCycles = MAX_UINT64;
+
+  Table = PmuProfileGetTable ();
+  if (Table == NULL || Table->NumRegions == PMU_PROFILE_MAX_REGIONS) {
+    return;
+  }
+
+  Table->Regions[Table->NumRegions++] = Region;
+  mModuleRegions[mNumModuleRegions++] = Region;
+}
+
+VOID
+EFIAPI
+PmuProfileBegin (
+  IN PMU_PROFILE_REGION  *Region
+  )
+{
+  if (!Region->Registered) {
+    PmuProfileRegister (Region);
+  }
+
+  PmuProfileReadEvents (Region->StartEvents);
+  Region->StartCycles = PmuProfileReadCycles ();
+}
+
+VOID
+EFIAPI
+PmuProfileEnd (
+  IN PMU_PROFILE_REGION  *Region
+  )
+{
+  UINT64 Cycles;
+  UINT32 Events[PMU_PROFILE_EVENTS];
+  UINTN Bucket;
+  UINTN Index;
+
+  Cycles = PmuProfileReadCycles () - Region->StartCycles;
+  PmuProfileReadEvents (Events);
+
+  Region->Count++;
+  Region->TotalCycles += Cycles;
+  Region->MinCycles = MIN (Region->MinCycles, Cycles);
+  Region->MaxCycles = MAX (Region->MaxCycles, Cycles);
+  for (Index = 0; Index < PMU_PROFILE_EVENTS; Index++) {
+    // The event counters are 32 bits wide.
+    Region->TotalEvents[Index] += (UINT32)(Events[Index] - Region->StartEvents[Index]);
+  }
+
+  Bucket = Cycles == 0 ? 0 : (UINTN)HighBitSet64 (Cycles);
+  Region->Histogram[MIN (Bucket, PMU_PROFILE_BUCKETS - 1)]++;
+}
+
+EFI_STATUS
+EFIAPI
+PmuProfileLibDestructor (
+  IN EFI_HANDLE         ImageHandle,
+  IN EFI_SYSTEM_TABLE   *SystemTable
+  )
+{
+  PMU_PROFILE_TABLE *Table;
+  UINTN Index;
+  UINTN Region;
+
+  Table = mPmuProfileTable;
+  if (Table == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  for (Region = 0; Region < mNumModuleRegions; Region++) {
+    for (Index = 0; Index < Table->NumRegions; Index++) {
+      if (Table->Regions[Index] == mModuleRegions[Region]) {
+        Table->Regions[Index] = Table->Regions[--Table->NumRegions];
+        break;
+      }
+    }
+  }
+
+  return EFI_SUCCESS;
+}
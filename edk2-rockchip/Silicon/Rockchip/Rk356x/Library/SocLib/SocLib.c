@@ -10,6 +10,7 @@
 
 #include <Library/IoLib.h>
 #include <Library/DebugLib.h>
+#include <Library/TimerLib.h>
 #include <Library/SocLib.h>
 
 #include <IndustryStandard/Rk356x.h>
@@ -23,6 +24,32 @@
 #define PMU_GRF_IO_VSEL1                      (PMU_GRF + 0x0144)
 #define PMU_GRF_IO_VSEL2                      (PMU_GRF + 0x0148)
 
+// PMU registers
+#define PMU_BUS_IDLE_SFTCON0                  (PMU_BASE + 0x0050)
+#define PMU_BUS_IDLE_ACK                      (PMU_BASE + 0x0060)
+#define PMU_BUS_IDLE_ST                       (PMU_BASE + 0x0068)
+#define PMU_PWR_DWN_ST                        (PMU_BASE + 0x0098)
+#define PMU_PWR_GATE_SFTCON                   (PMU_BASE + 0x00A0)
+
+#define PMU_PD_POLL_US                        10
+#define PMU_PD_TIMEOUT_US                     10000
+
+// Power gate and bus idle request bits, indexed by PMU_POWER_DOMAIN
+STATIC CONST struct {
+  UINT32  PwrBit;
+  UINT32  ReqBit;
+} mPowerDomains[] = {
+  [PMU_PD_GPU]    = { BIT0, BIT1 },
+  [PMU_PD_NPU]    = { BIT1, BIT2 },
+  [PMU_PD_VPU]    = { BIT2, BIT6 },
+  [PMU_PD_RKVENC] = { BIT3, BIT7 },
+  [PMU_PD_RKVDEC] = { BIT4, BIT8 },
+  [PMU_PD_RGA]    = { BIT5, BIT5 },
+  [PMU_PD_VI]     = { BIT6, BIT3 },
+  [PMU_PD_VO]     = { BIT7, BIT4 },
+  [PMU_PD_PIPE]   = { BIT8, BIT11 },
+};
+
 SOC_BOOT_DEVICE
 SocGetBootDevice (
   VOID
@@ -76,4 +103,80 @@ SocSetDomainVoltage (
     }
     break;
   }
+}
+
+STATIC
+EFI_STATUS
+SocWaitPmu (
+  UINTN Reg,
+  UINT32 Mask,
+  UINT32 Value
+  )
+{
+  UINT32 Timeout;
+
+  for (Timeout = PMU_PD_TIMEOUT_US; Timeout > 0; Timeout -= PMU_PD_POLL_US) {
+    if ((MmioRead32 (Reg) & Mask) == Value) {
+      return EFI_SUCCESS;
+    }
+    MicroSecondDelay (PMU_PD_POLL_US);
+  }
+
+  return EFI_TIMEOUT;
+}
+
+/*
+ * Power a domain up or down. The domain's bus interface is idled before
+ * power is removed and released after it is restored, as the Linux
+ * rockchip power domain driver does. Clocks into the domain must be
+ * running while this is called.
+ */
+EFI_STATUS
+SocSetPowerDomain (
+  PMU_POWER_DOMAIN PowerDomain,
+  BOOLEAN Enable
+  )
+{
+  UINT32 PwrBit;
+  UINT32 ReqBit;
+  EFI_STATUS Status;
+
+  ASSERT (PowerDomain < ARRAY_SIZE (mPowerDomains));
+  PwrBit = mPowerDomains[PowerDomain].PwrBit;
+  ReqBit = mPowerDomains[PowerDomain].ReqBit;
+
+  if (Enable) {
+    MmioWrite32 (PMU_PWR_GATE_SFTCON, PwrBit << 16);
+    Status = SocWaitPmu (PMU_PWR_DWN_ST, PwrBit, 0);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "PMU: Power domain %u power up timed out\n", PowerDomain));
+      return Status;
+    }
+
+    MmioWrite32 (PMU_BUS_IDLE_SFTCON0, ReqBit << 16);
+    Status = SocWaitPmu (PMU_BUS_IDLE_ACK, ReqBit, 0);
+    if (!EFI_ERROR (Status)) {
+      Status = SocWaitPmu (PMU_BUS_IDLE_ST, ReqBit, 0);
+    }
+  } else {
+    MmioWrite32 (PMU_BUS_IDLE_SFTCON0, (ReqBit << 16) | ReqBit);
+    Status = SocWaitPmu (PMU_BUS_IDLE_ACK, ReqBit, ReqBit);
+    if (!EFI_ERROR (Status)) {
+      Status = SocWaitPmu (PMU_BUS_IDLE_ST, ReqBit, ReqBit);
+    }
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "PMU: Power domain %u idle request timed out\n", PowerDomain));
+      return Status;
+    }
+
+    MmioWrite32 (PMU_PWR_GATE_SFTCON, (PwrBit << 16) | PwrBit);
+    Status = SocWaitPmu (PMU_PWR_DWN_ST, PwrBit, PwrBit);
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "PMU: Power domain %u %a timed out\n", PowerDomain,
+            Enable ? "bus idle release" : "power down"));
+  }
+
+  return Status;
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+#
+# Script to convert a BMP logo into the raw form read by LogoDxe.
+#
+# Writes two files:
+#   <out>.raw  pixels as EFI_GRAPHICS_OUTPUT_BLT_PIXEL (B, G, R, 0), top row
+#              first, ready to hand to GOP Blt
+#   <out>.dim  UINT32 width and UINT32 height, little endian
+#
+# Only uncompressed 24 and 32 bpp bitmaps are supported.
+
+import os
+import struct
+import sys
+
+def convert_bmp(bmp_file_name, out_prefix):
+    with open(bmp_file_name, "rb") as bmp_file:
+        bmp = bmp_file.read()
+
+    if bmp[0:2] != b'BM':
+        sys.exit('%s: not a BMP file' % bmp_file_name)
+
+    offset, = struct.unpack_from('<I', bmp, 10)
+    width, height, planes, bpp, compression = \
+        struct.unpack_from('<iiHHI', bmp, 18)
+    if bpp not in (24, 32) or compression != 0:
+        sys.exit('%s: unsupported BMP (%u bpp, compression %u)' %
+                 (bmp_file_name, bpp, compression))
+
+    # Rows are stored bottom-up unless the height is negative
+    bottom_up = height > 0
+    height = abs(height)
+    pixel_bytes = bpp // 8
+    stride = (width * pixel_bytes + 3) & ~3
+
+    pixels = bytearray()
+    for y in range(height):
+        row = height - 1 - y if bottom_up else y
+        start = offset + row * stride
+        for x in range(width):
+            b, g, r = bmp[start + x * pixel_bytes:start + x * pixel_bytes + 3]
+            pixels += bytes((b, g, r, 0))
+
+    out_dir = os.path.dirname(out_prefix)
+    if out_dir:
+        os.makedirs(out_dir, exist_ok=True)
+    with open(out_prefix + '.raw', "wb") as raw:
+        raw.write(pixels)
+    with open(out_prefix + '.dim', "wb") as dim:
+        dim.write(struct.pack('<II', width, height))
+
+if len(sys.argv) != 3:
+    sys.exit('usage: %s <logo.bmp> <output prefix>' % sys.argv[0])
+
+convert_bmp(sys.argv[1], sys.argv[2])